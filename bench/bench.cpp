@@ -0,0 +1,122 @@
+/*
+ * Host micro-benchmark harness, see bench.h
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+static bench_config_t config = {NULL, BENCH_SAMPLES, BENCH_MIN_SAMPLE_NS, NULL};
+static bench_result_t results[BENCH_MAX_RESULTS];
+static uint32_t result_count;
+static volatile uint32_t sink;
+
+void bench_sink(uint32_t value) {
+  sink += value;
+}
+
+uint64_t bench_now_ns(void) {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void bench_init(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--filter") == 0 && value) {
+      config.filter = value;
+      i++;
+    } else if (strcmp(arg, "--samples") == 0 && value) {
+      config.samples = (uint32_t)strtoul(value, NULL, 10) | 1u;   // Keep it odd
+      i++;
+    } else if (strcmp(arg, "--min-ms") == 0 && value) {
+      config.min_sample_ns = strtoull(value, NULL, 10) * 1000000u;
+      i++;
+    } else if (strcmp(arg, "--trace") == 0 && value) {
+      config.trace = value;
+      i++;
+    } else {
+      fprintf(stderr, "usage: %s [--filter name] [--samples n] [--min-ms ms] [--trace file]\n", argv[0]);
+      exit(2);
+    }
+  }
+}
+
+bool bench_selected(const char *name) {
+  return config.filter == NULL || strstr(name, config.filter) != NULL;
+}
+
+const char *bench_trace_path(void) {
+  return config.trace;
+}
+
+// Time one sample of iters operations, in nanoseconds per operation
+static double sample(bench_fn_t fn, uint32_t iters) {
+  uint64_t start = bench_now_ns();
+  fn(iters);
+  return (double)(bench_now_ns() - start) / iters;
+}
+
+// Median of n values; sorts them
+static double median(double *v, uint32_t n) {
+  std::sort(v, v + n);
+  return n & 1 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+const bench_result_t *bench_run(const char *name, uint32_t items, bench_fn_t fn) {
+  if (!bench_selected(name) || result_count >= BENCH_MAX_RESULTS) return NULL;
+
+  // Calibrate: double the iterations until one sample is long enough
+  uint32_t iters = 1;
+  for (;;) {
+    uint64_t start = bench_now_ns();
+    fn(iters);
+    uint64_t elapsed = bench_now_ns() - start;
+    if (elapsed >= config.min_sample_ns || iters >= (1u << 30)) break;
+    // Jump close to the target once the time is measurable, then settle by doubling
+    uint64_t scale = elapsed > 1000 ? config.min_sample_ns / elapsed : 2;
+    uint64_t next = (uint64_t)iters * std::min<uint64_t>(std::max<uint64_t>(scale, 2), 1024);
+    iters = (uint32_t)std::min<uint64_t>(next, 1u << 30);
+  }
+
+  for (uint32_t i = 0; i < BENCH_WARMUP; i++) sample(fn, iters);
+
+  double *times = (double *)malloc(config.samples * sizeof(double));
+  double *dev = (double *)malloc(config.samples * sizeof(double));
+  for (uint32_t i = 0; i < config.samples; i++) times[i] = sample(fn, iters);
+
+  bench_result_t *r = &results[result_count++];
+  r->name = name;
+  r->items = items;
+  r->iters = iters;
+  r->samples = config.samples;
+  r->median = median(times, config.samples);   // Sorted from here on
+  r->min = times[0];
+  r->max = times[config.samples - 1];
+  for (uint32_t i = 0; i < config.samples; i++) dev[i] = fabs(times[i] - r->median);
+  r->mad = median(dev, config.samples);
+  r->mitems_per_s = r->median > 0 ? r->items * 1000.0 / r->median : 0;
+  free(times);
+  free(dev);
+
+  fprintf(stderr, "bench: %-28s %12.1f ns/op  mad %8.1f  (%u x %u)", name, r->median, r->mad, r->samples, r->iters);
+  if (items > 1) fprintf(stderr, "  %8.1f M/s", r->mitems_per_s);
+  fprintf(stderr, "\n");
+  return r;
+}
+
+void bench_write_json(FILE *out, const char *suite) {
+  fprintf(out, "{\n  \"suite\": \"%s\",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [", suite);
+  for (uint32_t i = 0; i < result_count; i++) {
+    const bench_result_t *r = &results[i];
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"items\": %u, \"iters\": %u, \"samples\": %u, "
+                 "\"median\": %.3f, \"mad\": %.3f, \"min\": %.3f, \"max\": %.3f, \"mitems_per_s\": %.3f}",
+            i ? "," : "", r->name, r->items, r->iters, r->samples, r->median, r->mad, r->min, r->max,
+            r->mitems_per_s);
+  }
+  fprintf(out, "\n  ]\n}\n");
+}
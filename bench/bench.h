@@ -0,0 +1,70 @@
+/*
+ * Host micro-benchmark harness
+ *
+ * Times a benchmark body in samples: each sample runs the body for enough
+ * iterations to last at least BENCH_MIN_SAMPLE_NS (the count is calibrated
+ * once per benchmark by doubling), after a few warm-up samples that are
+ * thrown away. The result of a benchmark is the median and the median
+ * absolute deviation (MAD) of the per-iteration times, which stay stable on
+ * shared CI machines where a mean is dragged around by the odd preemption.
+ *
+ * A benchmark that names the items one operation works on (pixels, rows)
+ * also gets a throughput in million items per second.
+ *
+ * Results are collected and written as one JSON document; progress goes to
+ * stderr so stdout can be redirected to a file.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 31u              // Samples per benchmark (odd, so the median is one sample)
+#endif
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 3u                // Samples run and discarded before measuring
+#endif
+#ifndef BENCH_MIN_SAMPLE_NS
+#define BENCH_MIN_SAMPLE_NS 2000000u   // Shortest sample, so the clock resolution does not matter
+#endif
+#ifndef BENCH_MAX_RESULTS
+#define BENCH_MAX_RESULTS 32u          // Benchmarks per run
+#endif
+
+// Run the measured operation iters times
+typedef void (*bench_fn_t)(uint32_t iters);
+
+// Statistics of one benchmark, times in nanoseconds per operation
+typedef struct {
+  const char *name;
+  uint32_t items;           // Work items per operation (pixels, rows, samples), 1 if not meaningful
+  uint32_t iters;           // Operations per sample
+  uint32_t samples;         // Samples measured
+  double median;            // Median time
+  double mad;               // Median absolute deviation from the median
+  double min, max;          // Fastest and slowest sample
+  double mitems_per_s;      // Million items per second at the median (MP/s for pixel benchmarks)
+} bench_result_t;
+
+// Settings of a run, from the command line
+typedef struct {
+  const char *filter;       // Only run benchmarks whose name contains this, NULL for all
+  uint32_t samples;
+  uint64_t min_sample_ns;
+  const char *trace;        // File for a Chrome trace of the run, NULL for none
+} bench_config_t;
+
+void bench_init(int argc, char **argv);             // Parse --filter, --samples, --min-ms and --trace
+bool bench_selected(const char *name);              // True if the filter lets name run
+const char *bench_trace_path(void);                 // --trace file, NULL if not given
+const bench_result_t *bench_run(const char *name, uint32_t items, bench_fn_t fn); // Measure fn; NULL if filtered out
+void bench_write_json(FILE *out, const char *suite); // All results so far
+uint64_t bench_now_ns(void);                        // Monotonic clock
+
+// Keep a computed value alive so the compiler cannot drop the work producing it
+void bench_sink(uint32_t value);
+
+#endif // BENCH_H
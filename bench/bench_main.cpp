@@ -0,0 +1,414 @@
+/*
+ * UI core micro-benchmarks (PlatformIO env:native)
+ *
+ * Times the menu's hot paths on the host, against the real LVGL and the
+ * firmware modules that have no Arduino dependency: encoder decoding, touch
+ * filtering, one navigation step, moving the selected style, building the
+ * main list, opening and closing a sub page through the page arena,
+ * rendering a 10-row list scroll with label rows and with label cache
+ * rows, the flush path (shadow framebuffer diff and RGB444 packing), the
+ * fill, copy and blend kernels over one draw buffer (in MP/s), and a
+ * full-screen copy and blend on one thread and split in two bands
+ * (band_split, whose worker is a std::thread here). The display renders
+ * into the firmware's 10-row draw buffer and its flush callback only
+ * acknowledges the area, so the numbers are CPU cost on the build machine:
+ * compare them commit over commit on one machine, not against the ESP32.
+ *
+ * The navigation step is the firmware's own (menu_nav), linked here like
+ * the other modules.
+ *
+ * With the profiler compiled in, --trace writes the profiler ring as a
+ * Chrome trace when the run ends: render, flush and band blocks and the
+ * pool's heap use. The ring keeps the latest records, so filter down to
+ * the benchmark of interest.
+ *
+ *   pio run -e native && .pio/build/native/program > bench.json
+ *   .pio/build/native/program --filter flush --samples 51
+ *   PLATFORMIO_BUILD_FLAGS=-DPROF_ENABLE=1 pio run -e native
+ *   .pio/build/native/program --filter list_scroll --trace trace.json
+ */
+
+#include <lvgl.h>
+#include "bench.h"
+#include "band_split.h"
+#include "encoder.h"
+#include "label_cache.h"
+#include "lvgl_pool.h"
+#include "menu_nav.h"
+#include "menu_rows.h"
+#include "prof.h"
+#include "render_kernels.h"
+#include "scroll_anim.h"
+#include "shadow_fb.h"
+#include "touch_filter.h"
+
+#define FRAME_MS 10u            // LVGL_REFRESH_TIME of the firmware
+#define MAIN_ROWS 5             // Rows of the main list
+#define SUB_ROWS 4              // Rows of a sub page, "Return" included
+#define NAV_ROWS 16             // Rows of the navigation list, more than fit so steps scroll
+#define SCROLL_ROWS 10          // Rows of the scroll render list, as in the firmware's label bench
+#define ENCODER_SAMPLES 256u    // Recorded pin samples replayed by encoder_decode
+#define TOUCH_SAMPLES 256u      // Noisy touch samples replayed by touch_filter
+
+static const uint32_t screenWidth = 320;     // Width of the screen
+static const uint32_t screenHeight = 240;    // Height of the screen
+static const uint32_t bandRows = 10;         // Rows of the draw buffer
+static lv_color_t buf[screenWidth * bandRows];
+static lv_disp_draw_buf_t draw_buf;
+static lv_disp_drv_t disp_drv;
+
+static lv_style_t *selected_style = (lv_style_t *)&menu_style_selected;
+static lv_obj_t *nav_list;
+static lv_obj_t *nav_items[NAV_ROWS];
+static int nav_cursor;
+static bool nav_highlighted;
+static scroll_anim_t nav_anim;
+static lv_obj_t *nav_scrolled;               // List nav_anim last moved
+static uint32_t nav_ms;                      // Simulated time of the scroll animation
+static lv_obj_t *scroll_list;
+static uint32_t scroll_row;
+
+static uint8_t enc_a[ENCODER_SAMPLES], enc_b[ENCODER_SAMPLES];
+static int16_t touch_x[TOUCH_SAMPLES], touch_y[TOUCH_SAMPLES];
+static touch_filter_t touch;
+static uint16_t band_a[screenWidth * bandRows], band_b[screenWidth * bandRows];
+static uint16_t kernel_buf[screenWidth * bandRows];  // Target of the kernel benchmarks
+static uint8_t packed[screenWidth * bandRows * 3 / 2 + 1];
+static uint16_t screen[screenWidth * screenHeight];  // Full-screen target of the band benchmarks
+static uint16_t backdrop[screenWidth * screenHeight];  // What the band benchmarks draw before blending
+static const lv_color_t band_color = LV_COLOR_MAKE(0x20, 0x80, 0xF0);
+
+// Flush callback of the host display: the panel transfer is not part of these benchmarks
+static void bench_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  PROF_SCOPE(PROF_FLUSH);
+  lv_disp_flush_ready(disp);
+}
+
+// Render the invalidated areas now, as the firmware's timer handler does
+static void render() {
+  PROF_SCOPE(PROF_TIMER);
+  lv_refr_now(NULL);
+  if (PROF_ENABLE) {
+    lvgl_pool_mon_t mon;
+    lvgl_pool_monitor(&mon);
+    prof_counter(PROF_HEAP, mon.used);   // Heap track of the trace
+  }
+}
+
+// Rows report clicks to their list like on the device; nothing clicks here
+static void row_clicked(lv_event_t *e) {
+}
+
+// Drop the invalidated areas; rendering is timed only where a benchmark asks for it
+static void discard_invalid() {
+  lv_disp_get_default()->inv_p = 0;
+}
+
+// Create a list the way the firmware builds its pages: lean rows with cached text, clicks bubbling to one callback
+static lv_obj_t *create_list(lv_obj_t **items, int rows, const char *first, const char *text) {
+  lv_obj_t *list = lv_list_create(lv_scr_act());
+  lv_obj_add_event_cb(list, row_clicked, LV_EVENT_CLICKED, NULL);
+  for (int i = 0; i < rows; i++) {
+    items[i] = menu_rows_add_cached(list, i == 0 ? LV_SYMBOL_LEFT : LV_SYMBOL_RIGHT, i == 0 ? first : text);
+    lv_obj_add_flag(items[i], LV_OBJ_FLAG_EVENT_BUBBLE);
+  }
+  lv_obj_align(list, LV_ALIGN_CENTER, 0, 0);
+  return list;
+}
+
+// One encoder frame of the navigation list, as handle_encoder_list() does it
+static void nav_step(int32_t delta) {
+  if (menu_nav_move(nav_items, NAV_ROWS, &nav_cursor, &nav_highlighted, delta, selected_style)) {
+    menu_nav_follow(&nav_anim, &nav_scrolled, nav_list, nav_items[nav_cursor], nav_ms);
+  }
+}
+
+static void bench_encoder_decode(uint32_t iters) {
+  uint8_t last_a = 0;
+  int32_t pos = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    pos += encoder_decode(&last_a, enc_a[i % ENCODER_SAMPLES], enc_b[i % ENCODER_SAMPLES]);
+  }
+  bench_sink((uint32_t)pos);
+}
+
+// One raw touch sample through the whole filter pipeline
+static void bench_touch_filter(uint32_t iters) {
+  int16_t x = 0, y = 0;
+  for (uint32_t i = 0; i < iters; i++) {
+    touch_filter_update(&touch, true, touch_x[i % TOUCH_SAMPLES], touch_y[i % TOUCH_SAMPLES], 1000, &x, &y);
+  }
+  bench_sink((uint32_t)(x + y));
+}
+
+// Move the highlight between two neighbouring rows, without scrolling
+static void bench_restyle(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    menu_nav_move(nav_items, NAV_ROWS, &nav_cursor, &nav_highlighted, nav_cursor & 1 ? -1 : 1, selected_style);
+    discard_invalid();
+  }
+}
+
+// One step down the list and one frame of the scroll it starts
+static void bench_nav_step(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    nav_step(1);
+    nav_ms += FRAME_MS;
+    int32_t y;
+    if (scroll_anim_step(&nav_anim, nav_ms, &y)) {
+      lv_obj_scroll_to_y(nav_list, y, LV_ANIM_OFF);
+    }
+    discard_invalid();
+  }
+}
+
+// Build the main list, lay it out and delete it again
+static void bench_list_create(uint32_t iters) {
+  lv_obj_t *items[MAIN_ROWS];
+  for (uint32_t i = 0; i < iters; i++) {
+    lv_obj_t *list = create_list(items, MAIN_ROWS, "Item", "Item");
+    lv_obj_update_layout(list);
+    lv_obj_del(list);
+    discard_invalid();
+  }
+}
+
+// Open a sub page from the arena, draw it, close it and draw what was under it
+static void bench_submenu(uint32_t iters) {
+  lv_obj_t *items[SUB_ROWS];
+  for (uint32_t i = 0; i < iters; i++) {
+    bool in_arena = lvgl_arena_begin();
+    lv_obj_t *sublist = create_list(items, SUB_ROWS, "Return", "SubItem");
+    if (in_arena) lvgl_arena_end();
+    render();
+    lv_obj_del(sublist);
+    render();
+  }
+}
+
+// A list on top of the screen whose rows are all made by add
+static lv_obj_t *create_scroll_list(lv_obj_t *(*add)(lv_obj_t *, const void *, const char *)) {
+  lv_obj_t *list = lv_list_create(lv_scr_act());
+  for (int i = 0; i < SCROLL_ROWS; i++) add(list, NULL, "SubItem");
+  lv_obj_align(list, LV_ALIGN_CENTER, 0, 0);
+  lv_refr_now(NULL);
+  return list;
+}
+
+// Scroll the next row into view and render every row of the list, as a highlight change does
+static void bench_scroll_render(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    lv_obj_scroll_to_view(lv_obj_get_child(scroll_list, scroll_row), LV_ANIM_OFF);
+    scroll_row = (scroll_row + 1) % SCROLL_ROWS;
+    lv_obj_invalidate(scroll_list);
+    render();
+  }
+}
+
+static void send_nothing(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, void *ctx) {
+  bench_sink((uint32_t)(w * h));
+}
+
+// A band that matches the shadow copy: the whole diff finds nothing to send
+static void bench_flush_unchanged(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    bench_sink(shadow_fb_update(0, 0, screenWidth, bandRows, band_a, send_nothing, NULL));
+  }
+}
+
+// Bands alternating with a moved highlight, so every diff finds changed runs
+static void bench_flush_changed(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    const uint16_t *band = (i & 1) ? band_a : band_b;
+    bench_sink(shadow_fb_update(0, 0, screenWidth, bandRows, band, send_nothing, NULL));
+  }
+}
+
+static void bench_flush_pack444(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    bench_sink(rgb565_pack444(packed, band_a, screenWidth * bandRows, true));
+    bench_sink(packed[i % sizeof(packed)]);
+  }
+}
+
+// Blend result for one background pixel of the blend benchmarks
+static uint16_t overlay_mix(uint16_t bg, void *ctx) {
+  lv_color_t c;
+  c.full = bg;
+  return lv_color_mix(band_color, c, LV_OPA_50).full;
+}
+
+// Band job: copy rows y0..y1-1 of the backdrop to the screen and blend a colour over them
+static void blend_band(int32_t y0, int32_t y1, void *ctx) {
+  rgb565_copy(screen + y0 * screenWidth, screenWidth, backdrop + y0 * screenWidth, screenWidth, screenWidth, y1 - y0);
+  rgb565_blend_color(screen + y0 * screenWidth, screenWidth, screenWidth, y1 - y0, overlay_mix, NULL,
+                     band_color.full, overlay_mix(band_color.full, NULL));
+}
+
+// A full-screen redraw (backdrop and translucent overlay) at whatever split threshold is set
+static void bench_band_blend(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    band_split_run(screenHeight, screenWidth * screenHeight, blend_band, NULL);
+    bench_sink(screen[i % (screenWidth * screenHeight)]);
+  }
+}
+
+static void bench_band_single(uint32_t iters) {
+  band_split_set_threshold(UINT32_MAX);
+  bench_band_blend(iters);
+}
+
+static void bench_band_split(uint32_t iters) {
+  band_split_set_threshold(0);
+  bench_band_blend(iters);
+}
+
+// One draw buffer of opaque fill, the kernel behind row backgrounds and the selected row
+static void bench_kernel_fill(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    rgb565_fill(kernel_buf, screenWidth, screenWidth, bandRows, (uint16_t)i);
+    bench_sink(kernel_buf[i % (screenWidth * bandRows)]);
+  }
+}
+
+// One draw buffer of opaque image copy
+static void bench_kernel_copy(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    rgb565_copy(kernel_buf, screenWidth, (i & 1) ? band_a : band_b, screenWidth, screenWidth, bandRows);
+    bench_sink(kernel_buf[i % (screenWidth * bandRows)]);
+  }
+}
+
+// One draw buffer of translucent colour over list rows; restoring the rows first
+// is a kernel_copy, since blending the result again would flatten it
+static void bench_kernel_blend(uint32_t iters) {
+  for (uint32_t i = 0; i < iters; i++) {
+    rgb565_copy(kernel_buf, screenWidth, band_b, screenWidth, screenWidth, bandRows);
+    rgb565_blend_color(kernel_buf, screenWidth, screenWidth, bandRows, overlay_mix, NULL, 0, overlay_mix(0, NULL));
+    bench_sink(kernel_buf[i % (screenWidth * bandRows)]);
+  }
+}
+
+static uint32_t micros_clock() {
+  return (uint32_t)(bench_now_ns() / 1000u);
+}
+
+static void file_write(const char *text, void *ctx) {
+  fputs(text, (FILE *)ctx);
+}
+
+// Export the profiler ring to the --trace file
+static void write_trace(const char *path) {
+  if (!PROF_ENABLE) fprintf(stderr, "bench: built with PROF_ENABLE 0, %s holds no records\n", path);
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    fprintf(stderr, "bench: cannot write %s\n", path);
+    return;
+  }
+  prof_write_chrome(file_write, f);
+  fclose(f);
+}
+
+// Pin samples of a knob turned back and forth: a quadrature walk with random direction changes
+static void record_encoder() {
+  static const uint8_t gray[4] = {0, 1, 3, 2};   // B is bit 0, A bit 1
+  uint32_t seed = 1, state = 0;
+  for (uint32_t i = 0; i < ENCODER_SAMPLES; i++) {
+    seed = seed * 1103515245u + 12345u;
+    if ((seed >> 16) % 8 != 0) state += (seed >> 20) % 2 ? 1 : 3;   // Step, else the pins bounce in place
+    enc_a[i] = (gray[state % 4] >> 1) & 1;
+    enc_b[i] = gray[state % 4] & 1;
+  }
+}
+
+// Touch samples of a slow drag with panel jitter and an occasional glitch
+static void record_touch() {
+  uint32_t seed = 7;
+  for (uint32_t i = 0; i < TOUCH_SAMPLES; i++) {
+    seed = seed * 1103515245u + 12345u;
+    touch_x[i] = 40 + i + (int16_t)((seed >> 16) % 9) - 4;
+    touch_y[i] = 120 + (int16_t)((seed >> 24) % 9) - 4;
+    if (i % 32 == 31) touch_x[i] += 150;
+  }
+}
+
+// Draw-buffer bands of list rows: text-like runs on a white background, and the same with a row highlighted
+static void draw_bands() {
+  for (uint32_t i = 0; i < screenWidth * screenHeight; i++) {
+    backdrop[i] = ((i % screenWidth) / 3 + i / screenWidth) % 7 == 0 ? 0x0000 : 0xFFFF;
+  }
+  for (uint32_t y = 0; y < bandRows; y++) {
+    for (uint32_t x = 0; x < screenWidth; x++) {
+      uint16_t px = ((x / 3 + y) % 7 == 0 && x > 40 && x < 200) ? 0x0000 : 0xFFFF;
+      band_a[y * screenWidth + x] = px;
+      band_b[y * screenWidth + x] = (y >= 2 && y < 8 && px == 0xFFFF) ? 0x00F8 : px;   // Red, byte swapped
+    }
+  }
+}
+
+#ifndef PIO_UNIT_TESTING   // The tests link the same sources and bring their own main()
+int main(int argc, char **argv) {
+  bench_init(argc, argv);
+  prof_init(1000);                       // Host ticks are nanoseconds
+
+  lv_init();
+  lv_disp_draw_buf_init(&draw_buf, buf, NULL, screenWidth * bandRows);
+  lv_disp_drv_init(&disp_drv);
+  disp_drv.hor_res = screenWidth;
+  disp_drv.ver_res = screenHeight;
+  disp_drv.flush_cb = bench_flush;
+  disp_drv.draw_buf = &draw_buf;
+  lv_disp_drv_register(&disp_drv);
+
+  record_encoder();
+  record_touch();
+  touch_filter_init(&touch, NULL);
+  draw_bands();
+  shadow_fb_init(screenWidth, screenHeight, 0xFFFF, micros_clock);
+
+  nav_list = create_list(nav_items, NAV_ROWS, "Item", "Item");
+  lv_obj_update_layout(nav_list);
+  scroll_anim_init(&nav_anim, FRAME_MS, 0);
+  nav_step(0);                           // Highlight the first row
+  lv_refr_now(NULL);
+
+  bench_run("encoder_decode", 1, bench_encoder_decode);
+  bench_run("touch_filter", 1, bench_touch_filter);
+  bench_run("selection_restyle", 1, bench_restyle);
+  bench_run("nav_step", 1, bench_nav_step);
+  bench_run("list_create", MAIN_ROWS, bench_list_create);
+  bench_run("submenu_open_close", SUB_ROWS, bench_submenu);
+
+  scroll_list = create_scroll_list(menu_rows_add);
+  bench_run("list_scroll_labels", SCROLL_ROWS, bench_scroll_render);
+  lv_obj_del(scroll_list);
+  scroll_list = create_scroll_list(menu_rows_add_cached);
+  bench_run("list_scroll_cached", SCROLL_ROWS, bench_scroll_render);
+  lv_obj_del(scroll_list);
+
+  shadow_fb_update(0, 0, screenWidth, bandRows, band_a, send_nothing, NULL);   // The panel shows band_a
+  bench_run("flush_shadow_unchanged", screenWidth * bandRows, bench_flush_unchanged);
+  bench_run("flush_shadow_changed", screenWidth * bandRows, bench_flush_changed);
+  bench_run("flush_pack444", screenWidth * bandRows, bench_flush_pack444);
+  bench_run("kernel_fill", screenWidth * bandRows, bench_kernel_fill);
+  bench_run("kernel_copy", screenWidth * bandRows, bench_kernel_copy);
+  bench_run("kernel_blend", screenWidth * bandRows, bench_kernel_blend);
+
+  if (band_split_begin()) {
+    bench_run("band_blend_single", screenWidth * screenHeight, bench_band_single);
+    bench_run("band_blend_split", screenWidth * screenHeight, bench_band_split);
+    band_split_set_threshold(BAND_SPLIT_MIN_PIXELS);
+  }
+
+  lvgl_arena_stats_t arena;
+  lvgl_arena_get_stats(&arena);
+  if (arena.overflows) fprintf(stderr, "bench: %u page arena overflows, sub pages partly in the pool\n", arena.overflows);
+  label_cache_stats_t labels;
+  label_cache_get_stats(&labels);
+  if (labels.bypass) fprintf(stderr, "bench: %u rows fell back to labels, the label cache is full\n", labels.bypass);
+
+  if (bench_trace_path()) write_trace(bench_trace_path());
+  bench_write_json(stdout, "ui_core");
+  return 0;
+}
+#endif
@@ -0,0 +1,103 @@
+/*
+ * Allocation trace
+ *
+ * Every heap allocation of the firmware (malloc/calloc/realloc, and through
+ * them new and Arduino String) is routed through this module by linking with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc and defining ALLOC_TRACE. The LVGL pool reports its own allocations here too, and page
+ * arena bumps are counted apart since the arena memory is reserved up front.
+ *
+ * Allocations are counted per subsystem, taken from the scope the main loop
+ * is in (ALLOC_SCOPE). Once armed after setup(), each further allocation
+ * also leaves a record with call site, size and time, and in trap mode
+ * aborts with the call site so a no-malloc-after-boot build fails loudly.
+ * The wrappers run inside malloc, so this module never allocates and prints
+ * only through the callbacks it is given.
+ */
+
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ALLOC_TRACE_RECORDS
+#define ALLOC_TRACE_RECORDS 32      // Allocations after arming kept for dumping
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Part of the firmware an allocation is charged to
+typedef enum {
+  ALLOC_SUB_BOOT = 0,     // setup() and anything outside a scope
+  ALLOC_SUB_LVGL,         // lv_timer_handler(): rendering, timers, animations
+  ALLOC_SUB_INPUT,        // Encoder, button and touch handling, menu pages
+  ALLOC_SUB_SERIAL,       // Reports and Serial commands
+  ALLOC_SUB_COUNT
+} alloc_sub_t;
+
+// Where the memory came from
+typedef enum {
+  ALLOC_HEAP = 0,         // malloc/calloc/realloc
+  ALLOC_POOL,             // LVGL pool
+  ALLOC_ARENA,            // Page arena of the LVGL pool (reserved memory)
+  ALLOC_KIND_COUNT
+} alloc_kind_t;
+
+typedef enum {
+  ALLOC_TRACE_OFF = 0,    // Count only
+  ALLOC_TRACE_LOG,        // Count and record every allocation
+  ALLOC_TRACE_TRAP        // Record, then abort on the first heap or pool allocation
+} alloc_trace_mode_t;
+
+// One allocation made while armed
+typedef struct {
+  const void *site;       // Return address of the allocating call (resolve with addr2line)
+  uint32_t size;          // Bytes requested
+  uint32_t time_us;       // When it happened
+  uint8_t sub;            // alloc_sub_t
+  uint8_t kind;           // alloc_kind_t
+} alloc_record_t;
+
+// Allocation counts of one subsystem
+typedef struct {
+  uint32_t count[ALLOC_KIND_COUNT];   // Allocations per kind
+  uint32_t bytes[ALLOC_KIND_COUNT];   // Bytes per kind
+} alloc_sub_stats_t;
+
+// now_us timestamps records; fail prints a line before a trap aborts (must not allocate)
+void alloc_trace_init(uint32_t (*now_us)(void), void (*fail)(const alloc_record_t *rec));
+void alloc_trace_arm(alloc_trace_mode_t mode);          // Start recording (call at the end of setup())
+alloc_trace_mode_t alloc_trace_mode(void);
+alloc_sub_t alloc_trace_enter(alloc_sub_t sub);         // Charge allocations to sub; returns the previous scope
+void alloc_trace_leave(alloc_sub_t prev);
+void alloc_trace_note(alloc_kind_t kind, size_t size, const void *site); // Count an allocation not made through malloc
+
+void alloc_trace_get_stats(alloc_sub_t sub, alloc_sub_stats_t *out);
+uint32_t alloc_trace_since_arm(void);                   // Heap and pool allocations since arming
+uint32_t alloc_trace_recent(alloc_record_t *out, uint32_t max); // Copy the newest records, oldest first
+void alloc_trace_reset_stats(void);
+const char *alloc_trace_sub_name(alloc_sub_t sub);
+
+#ifdef __cplusplus
+}
+
+// Charge the allocations of the enclosing block to a subsystem
+class AllocScope {
+ public:
+  explicit AllocScope(alloc_sub_t sub) : prev_(alloc_trace_enter(sub)) {}
+  ~AllocScope() { alloc_trace_leave(prev_); }
+  AllocScope(const AllocScope &) = delete;
+  AllocScope &operator=(const AllocScope &) = delete;
+
+ private:
+  alloc_sub_t prev_;
+};
+
+#define ALLOC_SCOPE_CAT2(a, b) a##b
+#define ALLOC_SCOPE_CAT(a, b) ALLOC_SCOPE_CAT2(a, b)
+#define ALLOC_SCOPE(sub) AllocScope ALLOC_SCOPE_CAT(alloc_scope_, __LINE__)(sub)
+#endif
+
+#endif // ALLOC_TRACE_H
@@ -0,0 +1,46 @@
+/*
+ * Two-core band rendering
+ *
+ * Runs a row job on both cores: the rows of an area are split in two, the
+ * upper band goes to a worker pinned to the other core and the lower band
+ * runs on the caller, which then waits for the worker. Handing a job over
+ * costs a few microseconds, so areas below the break-even size (measured at
+ * boot, see band_split_set_threshold()) run on the caller only. Jobs must
+ * only touch the rows they are given. On hosts the worker is a std::thread,
+ * so the split can be measured off-target. No Arduino dependency.
+ */
+
+#ifndef BAND_SPLIT_H
+#define BAND_SPLIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BAND_SPLIT_ENABLE
+#define BAND_SPLIT_ENABLE 1         // Start the worker; 0 runs every job on the caller
+#endif
+#ifndef BAND_SPLIT_MIN_PIXELS
+#define BAND_SPLIT_MIN_PIXELS 2048u // Break-even area until a measured one is set
+#endif
+
+// Render rows y0 (inclusive) to y1 (exclusive) of the current job
+typedef void (*band_job_t)(int32_t y0, int32_t y1, void *ctx);
+
+// How the jobs were run
+typedef struct {
+  uint32_t split;           // Jobs shared with the worker
+  uint32_t single;          // Jobs run on the caller only (small or worker missing)
+} band_split_stats_t;
+
+bool band_split_begin(void);                       // Start the worker on the other core; false if it could not
+void band_split_set_threshold(uint32_t pixels);    // Smallest area that is split (UINT32_MAX = never)
+uint32_t band_split_threshold(void);
+
+// Run job over rows 0..rows-1 of an area of the given pixel count, split across
+// both cores when it is large enough. Returns true if it was split.
+bool band_split_run(int32_t rows, uint32_t pixels, band_job_t job, void *ctx);
+
+void band_split_get_stats(band_split_stats_t *out);
+void band_split_reset_stats(void);
+
+#endif // BAND_SPLIT_H
@@ -0,0 +1,70 @@
+/*
+ * Boot benchmarks
+ *
+ * Measurements run on the target once at the end of setup(), with the
+ * display, the touch bus and the main list up: flush byte order, label
+ * cache, icon decoding, band split, RGB444 transport, LVGL pool soak, page
+ * arena and RAM per list row. Each prints its result over Serial.
+ *
+ * BOOT_BENCH switches all of them in or out of the build; with it off
+ * boot_bench_run() returns at once and none of the code is linked. The
+ * count of each benchmark picks its length, 0 skips it. The benchmarks
+ * reach the menu of main.cpp only through boot_bench_ui_t.
+ */
+
+#ifndef BOOT_BENCH_H
+#define BOOT_BENCH_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+#ifndef BOOT_BENCH
+#define BOOT_BENCH 0                  // Run the benchmarks below at boot (0 = off)
+#endif
+#ifndef FLUSH_BENCH_FRAMES
+#define FLUSH_BENCH_FRAMES 20u        // Full frames pushed per byte-order mode
+#endif
+#ifndef LABEL_BENCH_RUNS
+#define LABEL_BENCH_RUNS 20u          // Scrolls of a 10-row list with labels and with cached label images
+#endif
+#ifndef ICON_BENCH_RUNS
+#define ICON_BENCH_RUNS 100u          // Full decodes of every menu icon
+#endif
+#ifndef BAND_BENCH_RUNS
+#define BAND_BENCH_RUNS 20u           // Full-screen redraws on one core and on both cores
+#endif
+#ifndef TRANSPORT_BENCH_FRAMES
+#define TRANSPORT_BENCH_FRAMES 0u     // Full-screen frames in RGB565 and RGB444 transport (12-bit panels only)
+#endif
+#ifndef SOAK_CYCLES
+#define SOAK_CYCLES 1000u             // Sublist open/close cycles that must leave the LVGL pool at its baseline
+#endif
+#ifndef ARENA_BENCH_CYCLES
+#define ARENA_BENCH_CYCLES 200u       // Sublist open/close cycles with and without the page arena
+#endif
+#ifndef ROW_RAM_BENCH
+#define ROW_RAM_BENCH 1               // Pool bytes per row and click dispatch for lists of 5, 100 and 1000 rows
+#endif
+
+// What the benchmarks use of the menu
+typedef struct {
+  const uint16_t *draw_buf;           // Pushed as it is by the flush benchmark
+  uint32_t width, height;             // Screen
+  uint32_t buf_rows;                  // Full rows the draw buffer holds
+  int items;                          // Main list items, each opens a sublist
+  void (*open_page)(int item);        // Create the sublist of a main item
+  void (*close_page)(void);           // Remove the sublist
+  bool *page_arena;                   // Build sublists in the page arena
+  bool *lean_rows;                    // Create rows with static text
+  lv_obj_t *(*add_row)(lv_obj_t *parent, const void *icon, const char *text);
+  const void *row_icon;               // Icon of a main list row (NULL without icons)
+  lv_style_t *selected_style;         // Style of the highlighted row
+} boot_bench_ui_t;
+
+void boot_bench_run(const boot_bench_ui_t *ui);   // Run every benchmark whose count is not 0
+
+// Hooks of the display flush for the transport benchmark
+bool boot_bench_bypass(void);                      // Send whole areas even where the shadow copy shows no change
+void boot_bench_flushed(const uint16_t *pixels, uint32_t n, bool solid); // Pixels sent; a solid flush is one colour n times
+
+#endif // BOOT_BENCH_H
@@ -0,0 +1,57 @@
+/*
+ * LVGL draw hooks
+ *
+ * Replaces the blend callback of LVGL's software draw context with one that
+ * sends the common unmasked cases (opaque fill, opaque image copy, solid
+ * colour with opacity) to the RGB565 kernels in render_kernels.h and leaves
+ * everything else to lv_draw_sw_blend_basic(). Install by setting
+ * disp_drv.draw_ctx_init = draw_hooks_ctx_init before registering the driver.
+ *
+ * An opaque fill covering the whole draw buffer is not written at all; it is
+ * remembered as a solid area and only materialised if something else is drawn
+ * on top. If nothing is, the flush callback takes the colour with
+ * draw_hooks_take_solid() and fills the panel directly.
+ *
+ * Kernel calls go through band_split_run(), so large areas are rendered in
+ * two row bands, one per core.
+ */
+
+#ifndef DRAW_HOOKS_H
+#define DRAW_HOOKS_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+#ifndef DRAW_HOOKS_DIRECT_FILL
+#define DRAW_HOOKS_DIRECT_FILL 1   // Defer full-buffer solid fills so the flush can fill the panel directly
+#endif
+#ifndef DRAW_HOOKS_VERIFY
+#define DRAW_HOOKS_VERIFY 0        // Re-run every fast blend through the reference blender and count mismatches
+#endif
+
+// Kernels used by the blend hook
+typedef enum {
+  DRAW_KERNEL_FILL = 0,
+  DRAW_KERNEL_COPY,
+  DRAW_KERNEL_BLEND,
+  DRAW_KERNELS
+} draw_kernel_t;
+
+// Work done by one kernel
+typedef struct {
+  uint32_t calls;
+  uint32_t pixels;
+  uint32_t cycles;
+} draw_kernel_stats_t;
+
+void draw_hooks_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx);   // Software draw context with the fast blend
+bool draw_hooks_take_solid(const void *buf, lv_color_t *color);            // True if buf is one solid colour that was never written
+// Time fills of w x 2..max_rows pixels in buf on one and on both cores; returns the break-even area (UINT32_MAX = never)
+uint32_t draw_hooks_calibrate_split(uint16_t *buf, int32_t w, int32_t max_rows, uint32_t repeat);
+void draw_hooks_get_stats(draw_kernel_t kernel, draw_kernel_stats_t *out); // Copy the statistics of a kernel
+uint32_t draw_hooks_fallbacks(void);                                        // Blends handed to the reference blender
+uint32_t draw_hooks_mismatches(void);                                       // Verification failures (DRAW_HOOKS_VERIFY)
+void draw_hooks_reset_stats(void);                                          // Start a new statistics window
+void draw_hooks_report(Print &out);                                         // Print per-kernel throughput in MPix/s
+
+#endif // DRAW_HOOKS_H
@@ -0,0 +1,36 @@
+/*
+ * Rotary encoder input
+ *
+ * Edges on encoder pin A are decoded in an interrupt and accumulated into a
+ * signed net delta. The main loop takes the delta once per frame, so a fast
+ * spin between two lv_timer_handler() calls costs a single selection update.
+ * Each step also wakes the loop when it is sleeping in encoder_wait().
+ */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Decode one sample of the encoder pins: returns +1 (clockwise), -1 or 0 when A did not change
+static inline int8_t encoder_decode(uint8_t *last_a, uint8_t a, uint8_t b) {
+  if (a == *last_a) return 0;
+  *last_a = a;
+  return b != a ? 1 : -1;
+}
+
+// Move a list cursor by a net delta, wrapping around inside 0..size-1
+static inline int encoder_wrap(int cursor, int32_t delta, int size) {
+  int32_t next = (cursor + delta) % size;
+  return next < 0 ? next + size : next;
+}
+
+void encoder_begin(uint8_t pin_a, uint8_t pin_b);  // Configure the pins and attach the edge interrupt
+int32_t encoder_take_delta(uint32_t *first_us);    // Return and clear the pending steps; first_us gets the time of the oldest one
+void encoder_wake_on_pin(uint8_t pin);             // Also end encoder_wait() on a falling edge of pin (e.g. a button)
+bool encoder_wait(uint32_t timeout_ms);            // Sleep until a step or wake edge arrives; false on timeout
+void encoder_inject(int32_t steps);                // Add synthetic steps (used by the fast-spin replay)
+uint32_t encoder_total_steps(void);                // Steps decoded since boot
+
+#endif // ENCODER_H
@@ -0,0 +1,63 @@
+/*
+ * Label bitmap cache
+ *
+ * Menu text is rendered once into an image in LVGL's true colour with
+ * alpha format (the text colour in every pixel, the glyph coverage as
+ * alpha) and shown by an lv_img instead of an lv_label. Repainting a row
+ * after a highlight change or a scroll is then one image blit, where a
+ * label rasterises its text glyph by glyph from the font on every redraw.
+ *
+ * Images are keyed by text, font and colour and live in a static store of
+ * LABEL_CACHE_BYTES, so the budget is the RAM the cache takes. A miss that
+ * does not fit evicts the least recently used images; an image is pinned
+ * while an lv_img shows it and released when that object is deleted. When
+ * nothing can be evicted the caller falls back to a label.
+ *
+ * Single line text without letter spacing, drawn in the font and colour
+ * the row has when it is created; state styles that change the text colour
+ * do not reach the image. Plain C, like the other LVGL-only modules.
+ */
+
+#ifndef LABEL_CACHE_H
+#define LABEL_CACHE_H
+
+#include <lvgl.h>
+
+#ifndef LABEL_CACHE_BYTES
+#define LABEL_CACHE_BYTES 8192u     // Byte budget for images and their keys
+#endif
+#ifndef LABEL_CACHE_ENTRIES
+#define LABEL_CACHE_ENTRIES 16u     // Images at most
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cache activity and occupancy
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t bypass;          // Misses that got no image: too large, or everything pinned
+  uint32_t bytes;           // Store bytes in use
+  uint32_t peak_bytes;
+  uint32_t entries;         // Images cached
+} label_cache_stats_t;
+
+// Image of text in font and colour, pinned until label_cache_release(); NULL if it cannot be cached
+const lv_img_dsc_t *label_cache_get(const char *text, const lv_font_t *font, lv_color_t color);
+void label_cache_release(const lv_img_dsc_t *img);     // Unpin an image from label_cache_get()
+
+// lv_img child of parent showing text in the parent's font and text colour; NULL if it cannot be cached
+lv_obj_t *label_cache_create(lv_obj_t *parent, const char *text);
+
+void label_cache_clear(void);                           // Drop every image that is not pinned
+void label_cache_get_stats(label_cache_stats_t *out);   // Copy the counters
+void label_cache_reset_stats(void);                     // Clear the counters (the images are kept)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LABEL_CACHE_H
@@ -0,0 +1,52 @@
+/*
+ * Input-to-photon latency
+ *
+ * Input events are tagged with the time of their first edge. When the next
+ * frame starts rendering, pending tags are bound to that frame, and when the
+ * last flush of the frame has left my_disp_flush() each tag becomes a latency
+ * record. Latencies are kept in a log-linear histogram for percentiles and
+ * the most recent records are kept for dumping. Timestamps are passed in, so
+ * the module has no Arduino dependency.
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#ifndef LATENCY_PENDING_MAX
+#define LATENCY_PENDING_MAX 8       // Input tags that can wait for a frame at once
+#endif
+#ifndef LATENCY_RECORDS
+#define LATENCY_RECORDS 32          // Recent per-event records kept for dumping
+#endif
+
+#define LATENCY_SUB_BITS 3          // Histogram resolution: 8 buckets per power of two
+#define LATENCY_BUCKETS (32 << LATENCY_SUB_BITS)
+
+// Source of an input event
+typedef enum {
+  LATENCY_SRC_ENCODER = 0,
+  LATENCY_SRC_BUTTON,
+  LATENCY_SRC_TOUCH
+} latency_src_t;
+
+// One completed input-to-photon measurement
+typedef struct {
+  uint32_t input_us;      // Time of the input edge
+  uint32_t latency_us;    // Time from the edge to the end of the last flush showing it
+  uint8_t src;            // latency_src_t
+} latency_record_t;
+
+void latency_input(latency_src_t src, uint32_t input_us);  // Tag an input that changed the UI
+uint32_t latency_frame_begin(void);                        // Bind pending tags to the frame about to render, returns its id
+uint32_t latency_current_frame(void);                      // Id of the frame being rendered
+void latency_frame_flushed(uint32_t frame, uint32_t now_us); // The last flush of a frame completed
+
+uint32_t latency_count(void);                              // Records since the last reset
+uint32_t latency_percentile(uint32_t pct);                 // Latency (us) at a percentile, from the histogram
+uint32_t latency_max(void);                                // Worst latency since the last reset
+uint32_t latency_recent(latency_record_t *out, uint32_t max); // Copy the newest records, oldest first
+void latency_reset(void);                                  // Clear the histogram
+
+#endif // LATENCY_H
@@ -0,0 +1,86 @@
+/**
+ * @file lv_conf.h
+ * Configuration file for LVGL v8.4.0
+ *
+ * Only the options this project changes are listed here; everything else
+ * keeps the defaults from lv_conf_internal.h. The file is found by LVGL
+ * through LV_CONF_INCLUDE_SIMPLE and the include path set in platformio.ini.
+ */
+
+/* clang-format off */
+#if 1 /*Set it to "1" to enable content*/
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#include <stdint.h>
+
+/*====================
+   COLOR SETTINGS
+ *====================*/
+
+/*Color depth: 1 (1 byte per pixel), 8 (RGB332), 16 (RGB565), 32 (ARGB8888)*/
+#define LV_COLOR_DEPTH 16
+
+/*Swap the 2 bytes of RGB565 color. Useful if the display has an 8-bit interface (e.g. SPI).
+ *With the swap enabled LVGL renders in the panel's byte order and my_disp_flush() can send
+ *the draw buffer untouched (no per-pixel swap on the CPU, DMA friendly).*/
+#ifndef LV_COLOR_16_SWAP
+#define LV_COLOR_16_SWAP 1
+#endif
+
+/*=========================
+   MEMORY SETTINGS
+ *=========================*/
+
+/*LVGL allocates from its own pool (src/lvgl_pool.cpp): size and placement are set with
+ *LVGL_POOL_SIZE and LVGL_POOL_PSRAM, and lvgl_pool_monitor() replaces lv_mem_monitor()*/
+#define LV_MEM_CUSTOM 1
+#if LV_MEM_CUSTOM
+    #define LV_MEM_CUSTOM_INCLUDE "lvgl_pool.h"
+    #define LV_MEM_CUSTOM_ALLOC(size)      lvgl_pool_alloc_at(size, __builtin_return_address(0))
+    #define LV_MEM_CUSTOM_FREE             lvgl_pool_free
+    #define LV_MEM_CUSTOM_REALLOC(p, size) lvgl_pool_realloc_at(p, size, __builtin_return_address(0))
+#endif     /*LV_MEM_CUSTOM*/
+
+/*=========================
+   HAL SETTINGS
+ *=========================*/
+
+/*Default display refresh period [ms]. The main loop sets the real pace (adaptive refresh),
+ *so LVGL must not be slower than the loop's active period.*/
+#define LV_DISP_DEF_REFR_PERIOD 10
+
+/*Input device read period [ms]*/
+#define LV_INDEV_DEF_READ_PERIOD 10
+
+/*Use the Arduino millis() as the LVGL tick source. Host builds (env:native) have no Arduino
+ *and leave the tick to LVGL's own counter (lv_tick_inc()).*/
+#ifdef ARDUINO
+#define LV_TICK_CUSTOM 1
+#else
+#define LV_TICK_CUSTOM 0
+#endif
+#if LV_TICK_CUSTOM
+    #define LV_TICK_CUSTOM_INCLUDE "Arduino.h"         /*Header for the system time function*/
+    #define LV_TICK_CUSTOM_SYS_TIME_EXPR (millis())    /*Expression evaluating to current system time in ms*/
+#endif   /*LV_TICK_CUSTOM*/
+
+/*==================
+ *   FONT USAGE
+ *===================*/
+
+/*tools/font_subset.py defines MENU_FONT_SUBSET when it generated a font holding only the
+ *glyphs of the menu strings. It then replaces the full Montserrat 14 as the default font.*/
+#ifdef MENU_FONT_SUBSET
+    #define LV_FONT_MONTSERRAT_14 0
+    #define LV_FONT_CUSTOM_DECLARE LV_FONT_DECLARE(menu_font_subset)
+    #define LV_FONT_DEFAULT &menu_font_subset
+#else
+    #define LV_FONT_MONTSERRAT_14 1
+    #define LV_FONT_DEFAULT &lv_font_montserrat_14
+#endif
+
+#endif /*LV_CONF_H*/
+
+#endif /*End of "Content enable"*/
@@ -0,0 +1,85 @@
+/*
+ * LVGL memory pool
+ *
+ * Dedicated heap for LVGL objects, styles and buffers, hooked in through
+ * LV_MEM_CUSTOM in lv_conf.h. On the ESP32 the pool is one block taken at
+ * the first allocation (PSRAM or internal RAM, see LVGL_POOL_PSRAM) and
+ * managed by an ESP-IDF multi_heap, so LVGL's churn cannot fragment the
+ * system heap and the pool can report used/free/largest block at any time.
+ * On hosts the pool is a static block of the same size with a first-fit
+ * allocator, so used bytes, the largest free block and fragmentation are
+ * measured there too. Included by lv_mem.c, so the header is plain C.
+ *
+ * A page arena sits on top of the pool: between lvgl_arena_begin() and
+ * lvgl_arena_end() every LVGL allocation is bumped out of one fixed block.
+ * Frees of arena blocks only count down, and when the last one is freed
+ * (the page was deleted) the arena is reset in one step. A page's objects
+ * then never interleave with longer-lived allocations in the pool.
+ */
+
+#ifndef LVGL_POOL_H
+#define LVGL_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LVGL_POOL_SIZE
+#define LVGL_POOL_SIZE (48u * 1024u)   // Pool size in bytes
+#endif
+#ifndef LVGL_POOL_PSRAM
+#define LVGL_POOL_PSRAM 0              // Place the pool in PSRAM (falls back to internal RAM if there is none)
+#endif
+
+#ifndef LVGL_ARENA_SIZE
+#define LVGL_ARENA_SIZE (6u * 1024u)   // Page arena size in bytes; allocations beyond it go to the pool
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pool usage, in the spirit of lv_mem_monitor_t
+typedef struct {
+  uint32_t total;           // Pool size
+  uint32_t used;            // Bytes handed out
+  uint32_t free;            // Bytes free
+  uint32_t biggest_free;    // Largest block that can still be allocated
+  uint32_t min_free;        // Lowest free since boot
+  uint32_t blocks;          // Live allocations
+  uint8_t frag_pct;         // 100 - biggest_free / free, as LVGL computes it
+  uint8_t in_psram;         // 1 if the pool lives in PSRAM
+} lvgl_pool_mon_t;
+
+void *lvgl_pool_alloc(size_t size);
+void lvgl_pool_free(void *p);                       // LV_MEM_CUSTOM_FREE
+void *lvgl_pool_realloc(void *p, size_t size);
+
+// Same, with the call site the allocation trace records. LV_MEM_CUSTOM_ALLOC/_REALLOC expand
+// inside lv_mem_alloc()/lv_mem_realloc() and pass their return address, so records name the
+// LVGL function that asked for memory rather than lv_mem_alloc() itself.
+void *lvgl_pool_alloc_at(size_t size, const void *site);
+void *lvgl_pool_realloc_at(void *p, size_t size, const void *site);
+void lvgl_pool_monitor(lvgl_pool_mon_t *mon);       // Current usage
+
+// Page arena usage
+typedef struct {
+  uint32_t size;            // Arena size
+  uint32_t used;            // Bytes bumped since the last reset
+  uint32_t peak;            // Most bytes ever in use
+  uint32_t live;            // Blocks not freed yet
+  uint32_t allocs;          // Blocks handed out
+  uint32_t frees;           // Blocks freed
+  uint32_t overflows;       // Allocations that did not fit and went to the pool
+  uint32_t resets;          // Times the arena was emptied
+} lvgl_arena_stats_t;
+
+bool lvgl_arena_begin(void);                        // Allocate from the arena; false if the previous page still holds it
+void lvgl_arena_end(void);                          // Back to the pool; the arena resets when its last block is freed
+void lvgl_arena_get_stats(lvgl_arena_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LVGL_POOL_H
@@ -0,0 +1,35 @@
+/*
+ * Menu navigation step
+ *
+ * What one encoder frame does to a list: the selected style moves straight
+ * from the old row to the row the net delta lands on, and an eased scroll
+ * starts towards the offset that shows it. The style, the scroll animator
+ * and the time are passed in, so the module has no Arduino dependency and
+ * the host benchmark times the same code as the firmware.
+ */
+
+#ifndef MENU_NAV_H
+#define MENU_NAV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lvgl.h>
+#include "scroll_anim.h"
+
+// Selection restyles
+typedef struct {
+  uint32_t frames;          // Frames in which the selection moved
+  uint32_t styles;          // Style add/remove calls made by the selection updates
+  uint32_t max_styles;      // Most style calls made in a single frame
+} menu_nav_stats_t;
+
+// Move the highlight of items[0..size-1] by delta, wrapping; returns true if a style changed
+bool menu_nav_move(lv_obj_t **items, int size, int *cursor, bool *highlighted, int32_t delta, lv_style_t *style);
+
+// Scroll list with anim so that item is in view; *scrolled is the list anim last moved, and becomes list
+void menu_nav_follow(scroll_anim_t *anim, lv_obj_t **scrolled, lv_obj_t *list, lv_obj_t *item, uint32_t now_ms);
+
+void menu_nav_get_stats(menu_nav_stats_t *out);
+void menu_nav_reset_stats(void);
+
+#endif // MENU_NAV_H
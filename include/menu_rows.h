@@ -0,0 +1,35 @@
+/*
+ * Lean menu rows
+ *
+ * Rows of the menu lists without per-row copies. A row is an lv_list button
+ * whose label points at the caller's text (a string literal, so it stays in
+ * flash) instead of copying it to the LVGL heap, and the selected highlight
+ * is a const style whose properties live in flash. A row then costs only
+ * its objects and their style lists. menu_rows_add_cached() goes one step
+ * further and shows the text as an image from the label cache.
+ *
+ * Written in C because LV_STYLE_CONST_INIT uses designated initializers
+ * that C++ rejects.
+ */
+
+#ifndef MENU_ROWS_H
+#define MENU_ROWS_H
+
+#include <lvgl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const lv_style_t menu_style_selected;        // Red background of the highlighted row
+
+// Same row as lv_list_add_btn(), with text bound statically: it must outlive the row
+lv_obj_t *menu_rows_add(lv_obj_t *list, const void *icon, const char *text);
+// Same row with the text as a cached image (label_cache.h), or as above when it cannot be cached
+lv_obj_t *menu_rows_add_cached(lv_obj_t *list, const void *icon, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MENU_ROWS_H
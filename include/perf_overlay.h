@@ -0,0 +1,55 @@
+/*
+ * Performance overlay
+ *
+ * A small label in the top-right corner of lv_layer_sys() showing FPS, CPU
+ * load, flush bandwidth, LVGL heap use and input latency. A throttled LVGL
+ * timer samples the values through a callback and formats them into one of
+ * two static buffers; the label is pointed at the new text only when it
+ * differs from what is shown, so an unchanged overlay invalidates nothing.
+ * The label has a fixed size, so a change only invalidates its own corner
+ * and never relayouts the menu below it. The corner is not free to redraw
+ * though: LVGL 8.4 renders the active screen under an invalid area before
+ * the system layer, opaque or not, so every text change also repaints the
+ * part of the menu behind the label. The pixels counter measures that.
+ */
+
+#ifndef PERF_OVERLAY_H
+#define PERF_OVERLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lvgl.h>
+
+#ifndef PERF_OVERLAY_PERIOD_MS
+#define PERF_OVERLAY_PERIOD_MS 250u   // Sampling period of the overlay (4 updates per second)
+#endif
+#define PERF_OVERLAY_TEXT 96          // Size of each text buffer
+
+// Values shown, filled in by the sample callback
+typedef struct {
+  uint32_t fps_x10;         // Frames flushed per second, times 10
+  uint32_t cpu_pct;         // Share of the loop spent working
+  uint32_t flush_kbps;      // Bytes sent to the panel per second / 1024
+  uint32_t heap_used;       // LVGL pool bytes in use
+  uint32_t heap_pct;        // Same as a share of the pool
+  uint32_t latency_us;      // Input-to-photon latency (95th percentile)
+} perf_overlay_values_t;
+
+// Overlay work
+typedef struct {
+  uint32_t updates;         // Samples taken
+  uint32_t redraws;         // Samples whose text changed (label invalidated)
+  uint32_t pixels;          // Area invalidated by those changes, rendered with the menu below it
+} perf_overlay_stats_t;
+
+typedef void (*perf_overlay_sample_cb_t)(perf_overlay_values_t *out);
+
+void perf_overlay_create(perf_overlay_sample_cb_t sample, bool shown); // Create the label and its timer (after the display driver)
+void perf_overlay_show(bool shown);                 // Show or hide; the timer only runs while shown
+bool perf_overlay_shown(void);
+void perf_overlay_format(char *out, uint32_t size, const perf_overlay_values_t *v); // Text for a set of values
+
+void perf_overlay_get_stats(perf_overlay_stats_t *out);
+void perf_overlay_reset_stats(void);
+
+#endif // PERF_OVERLAY_H
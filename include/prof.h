@@ -0,0 +1,127 @@
+/*
+ * Hot-path profiler
+ *
+ * Scoped probes (PROF_SCOPE) time a block with the CPU cycle counter on the
+ * ESP32 (nanoseconds of std::chrono::steady_clock on the host) and write a
+ * 12-byte record into a ring buffer. Slots are claimed with an atomic
+ * increment, so both cores record without a lock. The ring keeps the latest
+ * PROF_RECORDS probes, and prof_read() copies them out for dumping.
+ * Counters (heap use, queue depths) go into the same ring as samples whose
+ * duration field holds the value. Spans that do not fit a block are timed
+ * with PROF_BEGIN/PROF_END. With PROF_ENABLE 0 (set it for the whole build,
+ * in build_flags) the probes compile to nothing, the clock is never read and
+ * the ring takes no RAM.
+ *
+ * The two ESP32 cores have their own, unsynchronised cycle counters. Each
+ * core lines its counter up with the shared esp_timer clock once, in
+ * prof_sync_core(), and prof_now() adds that core's offset, so records of
+ * both cores share one time base (to within about a microsecond). On the
+ * host every thread that calls prof_sync_core() gets a core number of its
+ * own, in the order they call it, so the trace keeps threads apart.
+ *
+ * prof_write_chrome() exports the ring as Chrome trace JSON through a text
+ * sink: Serial on the device, a file in the host benchmark.
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <xtensa/core-macros.h>
+#else
+#include <chrono>
+#endif
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0               // Compile the probes in (0 = PROF_SCOPE expands to nothing)
+#endif
+#ifndef PROF_RECORDS
+#define PROF_RECORDS 1024           // Probes kept in the ring (power of two)
+#endif
+
+// What a probe measures
+typedef enum {
+  PROF_LOOP = 0,          // One loop() iteration without the sleep
+  PROF_TIMER,             // lv_timer_handler()
+  PROF_FLUSH,             // my_disp_flush()
+  PROF_ENCODER,           // Encoder handlers
+  PROF_BUTTON,            // handle_button_press()
+  PROF_SCROLL,            // animate_scroll()
+  PROF_SERIAL,            // Serial commands and reports
+  PROF_SLEEP,             // encoder_wait() between loop iterations
+  PROF_BAND,              // Render band on the second core
+  PROF_HEAP,              // Counter: LVGL pool bytes in use
+  PROF_INV_AREAS,         // Counter: invalidated areas waiting for the next refresh
+  PROF_ID_COUNT
+} prof_id_t;
+
+#define PROF_FIRST_COUNTER PROF_HEAP
+
+// One timed block
+typedef struct {
+  uint32_t start;         // Ticks at entry
+  uint32_t ticks;         // Duration in ticks (value for a counter)
+  uint8_t id;             // prof_id_t
+  uint8_t core;           // Core the block ran on
+  uint16_t seq;           // Low bits of the record number, to spot overwritten gaps
+} prof_record_t;
+
+extern uint32_t prof_core_offset[2];         // Per-core shift of the cycle counter, see prof_sync_core()
+
+// Current tick count: CPU cycles on the ESP32 (on the common time base), nanoseconds on the host
+static inline uint32_t prof_now(void) {
+#if defined(ESP_PLATFORM)
+  return XTHAL_GET_CCOUNT() + prof_core_offset[xPortGetCoreID()];
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void prof_init(uint32_t ticks_per_us);       // Tick rate (CPU MHz on the ESP32, 1000 on the host); syncs the calling core
+void prof_sync_core(void);                   // Line up the calling core's counter; once on every other core that records
+uint32_t prof_ticks_per_us(void);
+void prof_record(prof_id_t id, uint32_t start); // Record a block from start to now
+void prof_counter(prof_id_t id, uint32_t value); // Record a counter sample
+void prof_pause(bool paused);                // Stop recording (while the ring is being dumped)
+uint32_t prof_count(void);                   // Records held by the ring
+uint32_t prof_read(prof_record_t *out, uint32_t from, uint32_t max); // Copy records from index from (0 = oldest)
+uint32_t prof_total(void);                   // Records written since boot
+const char *prof_name(prof_id_t id);
+
+// Receives exported text; ctx is passed through
+typedef void (*prof_write_t)(const char *text, void *ctx);
+// Write the ring as Chrome trace JSON (chrome://tracing, ui.perfetto.dev) and a newline; recording pauses meanwhile
+void prof_write_chrome(prof_write_t write, void *ctx);
+static inline bool prof_is_counter(prof_id_t id) { return id >= PROF_FIRST_COUNTER; }
+
+// Times the enclosing block
+class ProfScope {
+ public:
+  explicit ProfScope(prof_id_t id) : id_(id), start_(prof_now()) {}
+  ~ProfScope() { prof_record(id_, start_); }
+  ProfScope(const ProfScope &) = delete;
+  ProfScope &operator=(const ProfScope &) = delete;
+
+ private:
+  prof_id_t id_;
+  uint32_t start_;
+};
+
+#if PROF_ENABLE
+#define PROF_SCOPE_CAT2(a, b) a##b
+#define PROF_SCOPE_CAT(a, b) PROF_SCOPE_CAT2(a, b)
+#define PROF_SCOPE(id) ProfScope PROF_SCOPE_CAT(prof_scope_, __LINE__)(id)
+#define PROF_BEGIN(var) uint32_t var = prof_now()     // Start timing a span that is not a block
+#define PROF_END(id, var) prof_record(id, var)        // Record the span started by PROF_BEGIN(var)
+#else
+#define PROF_SCOPE(id) ((void)0)
+#define PROF_BEGIN(var) ((void)0)
+#define PROF_END(id, var) ((void)0)
+#endif
+
+#endif // PROF_H
@@ -0,0 +1,68 @@
+/*
+ * Adaptive refresh controller
+ *
+ * Chooses how long the main loop may sleep before the next frame. While an
+ * animation runs or input arrived recently the loop runs at the active
+ * period; once the screen is static it only wakes to poll the inputs that
+ * have no interrupt (touch), and encoder or button edges wake it at once.
+ * The controller also attributes loop time to each state so the report can
+ * show CPU utilisation and the effective refresh rate per state. Times are
+ * passed in, so the module has no Arduino dependency.
+ */
+
+#ifndef REFRESH_CTL_H
+#define REFRESH_CTL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef REFRESH_HOLD_MS
+#define REFRESH_HOLD_MS 1000u       // Time after the last input the loop keeps the active period
+#endif
+#ifndef REFRESH_IDLE_POLL_MS
+#define REFRESH_IDLE_POLL_MS 50u    // Sleep while static; bounds the touch polling delay
+#endif
+#define REFRESH_RATE_WINDOW_MS 1000u // Window of the effective rate measurement
+
+// What the UI is doing
+typedef enum {
+  REFRESH_IDLE = 0,         // Static screen
+  REFRESH_BROWSING,         // Recent input, nothing moving by itself
+  REFRESH_ANIMATING,        // An animation or pending redraw needs frames
+  REFRESH_STATES
+} refresh_state_t;
+
+// Loop time attributed to one state
+typedef struct {
+  uint32_t loops;           // Loop iterations
+  uint32_t frames;          // Iterations that flushed a frame
+  uint32_t busy_us;         // Time spent working
+  uint32_t wall_us;         // Time spent in total, sleeping included
+} refresh_state_stats_t;
+
+// State of the controller
+typedef struct {
+  refresh_state_t state;
+  uint32_t active_ms;               // Loop period while not idle
+  uint32_t last_input_ms;           // Time of the last input
+  uint32_t window_start_ms;         // Start of the current rate window
+  uint32_t window_frames;           // Frames flushed in the current rate window
+  uint32_t rate_mhz;                // Effective refresh rate of the last window in mHz
+  refresh_state_stats_t stats[REFRESH_STATES];
+} refresh_ctl_t;
+
+void refresh_ctl_init(refresh_ctl_t *r, uint32_t active_ms, uint32_t now_ms); // Start idle with the given active period
+void refresh_ctl_activity(refresh_ctl_t *r, uint32_t now_ms);                 // An input was seen
+
+// Pick the state for the next sleep. busy is true while something will redraw
+// without input (animation running, invalidated areas pending).
+refresh_state_t refresh_ctl_update(refresh_ctl_t *r, uint32_t now_ms, bool busy);
+uint32_t refresh_ctl_wait_ms(const refresh_ctl_t *r);                         // How long the loop may sleep now
+
+// Account one loop iteration to the current state: busy_us working, wall_us in total
+void refresh_ctl_account(refresh_ctl_t *r, uint32_t now_ms, uint32_t busy_us, uint32_t wall_us, bool flushed);
+uint32_t refresh_ctl_rate_mhz(const refresh_ctl_t *r);                        // Frames per 1000 s over the last window
+const char *refresh_ctl_state_name(refresh_state_t state);
+void refresh_ctl_reset_stats(refresh_ctl_t *r);                               // Start a new statistics window
+
+#endif // REFRESH_CTL_H
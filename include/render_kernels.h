@@ -0,0 +1,46 @@
+/*
+ * RGB565 render kernels
+ *
+ * Fill, copy and solid-colour blend loops for 16-bit draw buffers. Stores are
+ * done 32 bits (two pixels) at a time with unrolled inner loops; on hosts with
+ * SSE2 the fill uses 128-bit stores. The kernels work on raw uint16_t pixels
+ * so they are independent of LVGL and of the byte order of the buffer.
+ * Strides are in pixels.
+ *
+ * The RGB444 kernels convert a buffer for 12-bit panel transport (two pixels
+ * in three bytes) and measure the error that conversion introduces.
+ */
+
+#ifndef RENDER_KERNELS_H
+#define RENDER_KERNELS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Compute the blend result for one background pixel; ctx carries colour and opacity
+typedef uint16_t (*rgb565_mix_cb_t)(uint16_t bg, void *ctx);
+
+void rgb565_fill(uint16_t *dst, int32_t stride, int32_t w, int32_t h, uint16_t color);   // Solid opaque fill
+void rgb565_copy(uint16_t *dst, int32_t dst_stride, const uint16_t *src, int32_t src_stride,
+                 int32_t w, int32_t h);                                                    // Opaque image copy
+
+// Blend a solid colour over the buffer. Results are cached per distinct background
+// value (seeded with seed_bg -> seed_res), so flat backgrounds cost one mix call.
+void rgb565_blend_color(uint16_t *dst, int32_t stride, int32_t w, int32_t h,
+                        rgb565_mix_cb_t mix, void *ctx, uint16_t seed_bg, uint16_t seed_res);
+
+// Difference between RGB565 and its RGB444 transport, in 8-bit channel units
+typedef struct {
+  uint32_t pixels;          // Pixels compared
+  uint32_t changed;         // Pixels that differ on screen
+  uint32_t sum_abs;         // Sum of absolute channel errors
+  uint64_t sum_sq;          // Sum of squared channel errors
+  uint8_t max;              // Largest channel error
+} rgb444_error_t;
+
+// Pack n pixels into RGB444 (R1G1, B1R2, G2B2). swapped = source pixels are byte swapped
+// (panel order). An odd last pixel takes two bytes. Returns the number of bytes written.
+uint32_t rgb565_pack444(uint8_t *dst, const uint16_t *src, int32_t n, bool swapped);
+void rgb565_error444(const uint16_t *src, int32_t n, bool swapped, rgb444_error_t *acc);  // Add n pixels to acc
+
+#endif // RENDER_KERNELS_H
@@ -0,0 +1,37 @@
+/*
+ * Run-length encoded image decoder
+ *
+ * LVGL image decoder for the icons generated by tools/rle_icons.py
+ * (lv_img_dsc_t with cf = LV_IMG_CF_RAW_ALPHA and an "RLE1" stream). The
+ * decoder reports the images as LV_IMG_CF_TRUE_COLOR_ALPHA but never opens
+ * them as a whole: LVGL then asks for one line at a time, which is decoded
+ * into its line buffer using the per-row offset table, so drawing an icon
+ * needs no image-sized allocation.
+ */
+
+#ifndef RLE_IMG_H
+#define RLE_IMG_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+#define RLE_IMG_MAGIC "RLE1"
+
+// Decoding work
+typedef struct {
+  uint32_t lines;           // Lines decoded
+  uint32_t pixels;          // Pixels written
+  uint32_t cycles;          // CPU cycles spent in the decoder
+} rle_img_stats_t;
+
+void rle_img_init(void);                                    // Register the decoder with LVGL (after lv_init)
+bool rle_img_is_rle(const lv_img_dsc_t *img);               // True for an image produced by tools/rle_icons.py
+
+// Decode len pixels of row y starting at column x into out as lv_color_t + alpha (3 bytes per pixel).
+// Returns false if the span is outside the image or the stream is corrupt (out may be partly written).
+bool rle_img_decode_line(const lv_img_dsc_t *img, int32_t x, int32_t y, int32_t len, uint8_t *out);
+
+void rle_img_get_stats(rle_img_stats_t *out);
+void rle_img_reset_stats(void);
+
+#endif // RLE_IMG_H
@@ -0,0 +1,51 @@
+/*
+ * Encoder scroll animator
+ *
+ * Moves a list's scroll offset towards a target over a fixed budget of
+ * frames with an ease-out curve. The position is computed from the elapsed
+ * time, not per step, so a frame that comes late (a long flush or render)
+ * only makes the next jump larger and never stretches the animation. Flushes
+ * in this firmware are synchronous, so a step never overlaps a transfer and
+ * there is no in-flight state to wait for.
+ * A new target during a spin restarts the curve from the current position.
+ * Times are passed in, so the module has no Arduino dependency.
+ */
+
+#ifndef SCROLL_ANIM_H
+#define SCROLL_ANIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SCROLL_ANIM_FRAMES
+#define SCROLL_ANIM_FRAMES 12       // Frames a scroll takes at the nominal frame period
+#endif
+
+// Frame pacing while animating
+typedef struct {
+  uint32_t frames;          // Offsets applied
+  uint32_t dropped;         // Frame periods that passed without an applied offset
+  uint32_t active_ms;       // Time spent animating
+} scroll_anim_stats_t;
+
+// State of one animator
+typedef struct {
+  int32_t from, to;         // Offsets at the start and end of the curve
+  int32_t pos;              // Last offset handed out
+  uint32_t start_ms;        // Start of the curve
+  uint32_t last_ms;         // Time of the last applied offset
+  uint16_t frame_ms;        // Nominal frame period
+  bool active;
+  scroll_anim_stats_t stats;
+} scroll_anim_t;
+
+void scroll_anim_init(scroll_anim_t *a, uint16_t frame_ms, int32_t pos);   // Idle at pos, stats cleared
+void scroll_anim_jump(scroll_anim_t *a, int32_t pos);                      // Stop and continue from pos (e.g. new list)
+void scroll_anim_set_target(scroll_anim_t *a, int32_t target, uint32_t now_ms); // Animate from the current offset to target
+
+// Advance to now_ms. Returns true and writes the offset to apply when it
+// changed; returns false while idle.
+bool scroll_anim_step(scroll_anim_t *a, uint32_t now_ms, int32_t *pos);
+void scroll_anim_reset_stats(scroll_anim_t *a);                            // Start a new statistics window
+
+#endif // SCROLL_ANIM_H
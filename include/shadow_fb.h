@@ -0,0 +1,58 @@
+/*
+ * Shadow framebuffer
+ *
+ * Keeps a copy of what is on the panel and, for every flushed area, compares
+ * it row by row with the new pixels (two pixels per 32-bit compare). Only the
+ * changed runs are handed to the send callback; runs separated by a short
+ * gap are merged since a new address window costs more than a few pixels,
+ * and fully changed rows are grouped into one rectangle. The copy lives in
+ * PSRAM; a board without it only gets one with SHADOW_FB_INTERNAL, since
+ * 150 KB of internal RAM is most of what the rest of the firmware has.
+ * No Arduino dependency.
+ */
+
+#ifndef SHADOW_FB_H
+#define SHADOW_FB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SHADOW_FB_MERGE_GAP
+#define SHADOW_FB_MERGE_GAP 8u      // Unchanged pixels sent anyway to avoid a new address window
+#endif
+#ifndef SHADOW_FB_INTERNAL
+#define SHADOW_FB_INTERNAL 0        // Fall back to internal RAM on boards without PSRAM
+#endif
+#ifndef SHADOW_FB_MAX_RUNS
+#define SHADOW_FB_MAX_RUNS 8        // Runs per row before the whole row is sent instead
+#endif
+
+// Send x/y/w/h pixels (rows of w pixels, contiguous with stride w) to the panel
+typedef void (*shadow_fb_send_cb_t)(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, void *ctx);
+
+// Work done by the diff
+typedef struct {
+  uint32_t pixels_in;       // Pixels flushed by LVGL
+  uint32_t pixels_sent;     // Pixels that went to the panel
+  uint32_t spans;           // Address windows opened
+  uint32_t diff_us;         // Time spent comparing
+} shadow_fb_stats_t;
+
+// Allocate the shadow copy; the panel must currently be filled with color. False without PSRAM (see
+// SHADOW_FB_INTERNAL) or memory.
+bool shadow_fb_init(uint16_t width, uint16_t height, uint16_t color, uint32_t (*now_us)(void));
+bool shadow_fb_active(void);                            // True once the shadow copy is allocated
+
+// Diff a flushed area against the shadow, update it and send the changed runs.
+// pixels has w * h entries. Returns the number of pixels sent.
+uint32_t shadow_fb_update(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels,
+                          shadow_fb_send_cb_t send, void *ctx);
+// Same for a solid fill: returns true (and updates the shadow) if any pixel of the area differs from color
+bool shadow_fb_fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+// Copy an area the caller sent whole into the shadow, without comparing; no-op while inactive
+void shadow_fb_store(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels);
+
+void shadow_fb_get_stats(shadow_fb_stats_t *out);
+void shadow_fb_reset_stats(void);
+
+#endif // SHADOW_FB_H
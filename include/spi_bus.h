@@ -0,0 +1,74 @@
+/*
+ * Shared SPI bus scheduler
+ *
+ * The display and the touch controller share one SPI bus. Display flushes
+ * are split into chunks and the touch sampling job, which has the higher
+ * priority, is run between chunks whenever it is due. This keeps touch
+ * latency bounded by one chunk transfer even during full-screen redraws.
+ * Bus time and wait time are accounted per client. Buffers already in the
+ * panel's byte order are sent by DMA without touching the pixels.
+ *
+ * In RGB444 transport mode the panel is switched to 12 bits per pixel and
+ * every chunk is packed (two pixels in three bytes) just before it is sent,
+ * which cuts the bytes on the wire by a quarter. Only panels with a 12-bit
+ * COLMOD (ST7789, ST7735) support it; the ILI9341 has no such mode.
+ */
+
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#ifndef SPI_BUS_CHUNK_PIXELS
+#define SPI_BUS_CHUNK_PIXELS 1280u      // Largest display transfer between two touch slots (pixels)
+#endif
+#ifndef SPI_BUS_USE_DMA
+#define SPI_BUS_USE_DMA 1               // Send native-order pixel buffers by DMA instead of CPU copies
+#endif
+#ifndef SPI_BUS_TOUCH_PERIOD_US
+#define SPI_BUS_TOUCH_PERIOD_US 10000u  // Touch sampling period (microseconds)
+#endif
+
+#ifndef SPI_BUS_COLMOD_RGB444
+#define SPI_BUS_COLMOD_RGB444 0x03      // COLMOD value for 12 bits per pixel (ST7789/ST7735)
+#endif
+#define SPI_BUS_COLMOD_RGB565 0x55      // COLMOD value for 16 bits per pixel
+
+// Pixel format on the wire
+typedef enum {
+  SPI_BUS_RGB565 = 0,
+  SPI_BUS_RGB444
+} spi_bus_format_t;
+
+// Clients sharing the bus, in increasing priority
+typedef enum {
+  SPI_BUS_DISPLAY = 0,
+  SPI_BUS_TOUCH,
+  SPI_BUS_CLIENTS
+} spi_bus_client_t;
+
+// Bus usage of one client
+typedef struct {
+  uint32_t jobs;          // Completed jobs
+  uint32_t busy_us;       // Time spent owning the bus
+  uint32_t wait_us;       // Time spent blocked behind the other client's transfers
+  uint32_t max_wait_us;   // Worst single wait (touch: at most one display chunk)
+  uint32_t bytes;         // Bytes transferred (display)
+} spi_bus_stats_t;
+
+typedef void (*spi_bus_job_cb_t)(void);
+
+void spi_bus_init(TFT_eSPI *tft);                                       // Attach the scheduler to the display driver
+void spi_bus_set_format(spi_bus_format_t format);                      // Switch the panel and the display jobs to a wire format
+spi_bus_format_t spi_bus_format(void);
+void spi_bus_set_touch_job(spi_bus_job_cb_t job, uint32_t period_us);   // Register the periodic touch sampling job
+bool spi_bus_touch_service(bool force);                                 // Run the touch job if due (or if forced)
+void spi_bus_push_pixels(int32_t x, int32_t y, int32_t w, int32_t h,
+                         uint16_t *pixels, bool swap);                  // Display job: push a rectangle (swap = CPU byte swap needed)
+void spi_bus_fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color); // Display job: fill a rectangle on the panel
+void spi_bus_get_stats(spi_bus_client_t client, spi_bus_stats_t *out);  // Copy the statistics of a client
+void spi_bus_reset_stats(void);                                         // Start a new statistics window
+void spi_bus_report(Print &out);                                        // Print utilisation and waits of all clients
+
+#endif // SPI_BUS_H
@@ -0,0 +1,82 @@
+/*
+ * Touch filter pipeline
+ *
+ * Allocation-free, fixed-point filter for resistive touch samples. Each raw
+ * sample goes through a pressure threshold, outlier rejection against the
+ * running median, a median-of-N window, an IIR low-pass and finally a
+ * dead-zone so that a resting finger does not keep moving the reported point.
+ * An outlier only holds the output; a jump that persists for more than half
+ * the window is taken as a real move, so fast drags are followed.
+ * The filter has no Arduino dependency so it can be reused off-target.
+ */
+
+#ifndef TOUCH_FILTER_H
+#define TOUCH_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TOUCH_FILTER_MEDIAN_N
+#define TOUCH_FILTER_MEDIAN_N 5         // Samples in the median window (odd, at most TOUCH_FILTER_MAX_N)
+#endif
+#ifndef TOUCH_FILTER_IIR_SHIFT
+#define TOUCH_FILTER_IIR_SHIFT 2        // IIR weight of a new sample is 1 / 2^shift
+#endif
+#ifndef TOUCH_FILTER_DEADZONE
+#define TOUCH_FILTER_DEADZONE 2         // Movement in pixels ignored around the last reported point
+#endif
+#ifndef TOUCH_FILTER_Z_THRESHOLD
+#define TOUCH_FILTER_Z_THRESHOLD 350    // Minimum raw pressure counted as a touch
+#endif
+#ifndef TOUCH_FILTER_OUTLIER
+#define TOUCH_FILTER_OUTLIER 40         // Largest jump in pixels from the median accepted as valid
+#endif
+#ifndef TOUCH_FILTER_RELEASE_N
+#define TOUCH_FILTER_RELEASE_N 2        // Consecutive missing samples before a release is reported
+#endif
+
+#define TOUCH_FILTER_MAX_N 9            // Size of the static median window
+
+// Tunables of one filter instance
+typedef struct {
+  uint8_t median_n;       // Median window length (odd)
+  uint8_t iir_shift;      // IIR smoothing strength
+  uint8_t deadzone;       // Dead-zone radius in pixels
+  uint8_t release_n;      // Release debounce in samples
+  uint16_t z_threshold;   // Pressure threshold
+  uint16_t outlier;       // Outlier rejection distance in pixels
+} touch_filter_cfg_t;
+
+// Counters describing what the filter did with the samples it saw
+typedef struct {
+  uint32_t samples;           // Samples fed into the filter
+  uint32_t low_pressure;      // Samples dropped by the pressure threshold
+  uint32_t outliers;          // Samples held by outlier rejection
+  uint32_t deadzone_holds;    // Samples where the dead-zone held the output still
+} touch_filter_stats_t;
+
+// State of one filter instance
+typedef struct {
+  touch_filter_cfg_t cfg;
+  int16_t hist_x[TOUCH_FILTER_MAX_N];   // Median window, X
+  int16_t hist_y[TOUCH_FILTER_MAX_N];   // Median window, Y
+  uint8_t count;                        // Valid samples in the window
+  uint8_t head;                         // Next write position in the window
+  uint8_t missing;                      // Consecutive samples without a touch
+  uint8_t rejects;                      // Consecutive samples held as outliers
+  bool pressed;                         // Current debounced press state
+  int32_t acc_x, acc_y;                 // IIR accumulators (Q8)
+  int16_t out_x, out_y;                 // Last reported point
+  touch_filter_stats_t stats;
+} touch_filter_t;
+
+void touch_filter_default_cfg(touch_filter_cfg_t *cfg);           // Fill cfg from the TOUCH_FILTER_* defaults
+void touch_filter_init(touch_filter_t *f, const touch_filter_cfg_t *cfg); // Initialise a filter (cfg may be NULL)
+void touch_filter_reset(touch_filter_t *f);                       // Drop history, keep config and stats
+
+// Feed one raw sample. Returns the debounced press state and writes the
+// filtered point to out_x/out_y (the last point is held while released).
+bool touch_filter_update(touch_filter_t *f, bool touched, int16_t x, int16_t y, uint16_t z,
+                         int16_t *out_x, int16_t *out_y);
+
+#endif // TOUCH_FILTER_H
@@ -0,0 +1,118 @@
+/*
+ * Allocation trace, see alloc_trace.h
+ */
+
+#include <stdlib.h>
+#include "alloc_trace.h"
+
+static alloc_sub_stats_t sub_stats[ALLOC_SUB_COUNT];
+static volatile uint8_t scope = ALLOC_SUB_BOOT;      // Subsystem the main loop is in
+static alloc_trace_mode_t mode = ALLOC_TRACE_OFF;
+static uint32_t since_arm;                            // Heap and pool allocations since arming
+static alloc_record_t records[ALLOC_TRACE_RECORDS];   // Ring of allocations made while armed
+static uint32_t record_head;                          // Records written since arming
+static uint32_t (*clock_us)(void);
+static void (*fail_cb)(const alloc_record_t *rec);
+
+static const char *const sub_names[ALLOC_SUB_COUNT] = {"boot", "lvgl", "input", "serial"};
+
+void alloc_trace_init(uint32_t (*now_us)(void), void (*fail)(const alloc_record_t *rec)) {
+  clock_us = now_us;
+  fail_cb = fail;
+}
+
+void alloc_trace_arm(alloc_trace_mode_t m) {
+  since_arm = 0;
+  record_head = 0;
+  mode = m;
+}
+
+alloc_trace_mode_t alloc_trace_mode(void) {
+  return mode;
+}
+
+alloc_sub_t alloc_trace_enter(alloc_sub_t sub) {
+  alloc_sub_t prev = (alloc_sub_t)scope;
+  scope = sub;
+  return prev;
+}
+
+void alloc_trace_leave(alloc_sub_t prev) {
+  scope = prev;
+}
+
+void alloc_trace_note(alloc_kind_t kind, size_t size, const void *site) {
+  alloc_sub_stats_t *s = &sub_stats[scope];
+  s->count[kind]++;
+  s->bytes[kind] += size;
+  if (mode == ALLOC_TRACE_OFF) return;
+
+  // Other tasks allocate too, so the ring slot is claimed atomically
+  uint32_t slot = __atomic_fetch_add(&record_head, 1, __ATOMIC_RELAXED);
+  alloc_record_t *r = &records[slot % ALLOC_TRACE_RECORDS];
+  r->site = site;
+  r->size = size;
+  r->time_us = clock_us ? clock_us() : 0;
+  r->sub = scope;
+  r->kind = kind;
+  if (kind == ALLOC_ARENA) return;   // Reserved memory, not an allocation from a heap
+
+  __atomic_fetch_add(&since_arm, 1, __ATOMIC_RELAXED);
+  if (mode == ALLOC_TRACE_TRAP) {
+    mode = ALLOC_TRACE_OFF;          // The fail callback must not trap again
+    if (fail_cb) fail_cb(r);
+    abort();
+  }
+}
+
+void alloc_trace_get_stats(alloc_sub_t sub, alloc_sub_stats_t *out) {
+  *out = sub_stats[sub];
+}
+
+uint32_t alloc_trace_since_arm(void) {
+  return since_arm;
+}
+
+uint32_t alloc_trace_recent(alloc_record_t *out, uint32_t max) {
+  uint32_t head = record_head;
+  uint32_t n = head < ALLOC_TRACE_RECORDS ? head : ALLOC_TRACE_RECORDS;
+  if (n > max) n = max;
+  for (uint32_t i = 0; i < n; i++) {
+    out[i] = records[(head - n + i) % ALLOC_TRACE_RECORDS];
+  }
+  return n;
+}
+
+void alloc_trace_reset_stats(void) {
+  for (uint32_t i = 0; i < ALLOC_SUB_COUNT; i++) {
+    sub_stats[i] = alloc_sub_stats_t();
+  }
+}
+
+const char *alloc_trace_sub_name(alloc_sub_t sub) {
+  return sub < ALLOC_SUB_COUNT ? sub_names[sub] : "?";
+}
+
+#if defined(ALLOC_TRACE)
+// Linker wraps (-Wl,--wrap=...): __real_* are the C library functions
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  alloc_trace_note(ALLOC_HEAP, size, __builtin_return_address(0));
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+  alloc_trace_note(ALLOC_HEAP, n * size, __builtin_return_address(0));
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+  if (size) alloc_trace_note(ALLOC_HEAP, size, __builtin_return_address(0)); // realloc(p, 0) frees
+  return __real_realloc(p, size);
+}
+}
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Two-core band rendering, see band_split.h
+ */
+
+#include <string.h>
+#include "band_split.h"
+#include "prof.h"
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+static volatile band_job_t job_fn;        // Job handed to the worker
+static void *volatile job_ctx;
+static volatile int32_t job_y0, job_y1;
+static uint32_t threshold = BAND_SPLIT_MIN_PIXELS;
+static bool running;                      // Worker started
+static band_split_stats_t stats;
+
+#if defined(ESP_PLATFORM)
+static TaskHandle_t worker;
+static SemaphoreHandle_t done;            // Given by the worker when its band is finished
+
+// Worker on the other core: wait for a band, render it, signal
+static void worker_task(void *arg) {
+  prof_sync_core();                       // Band records share the time base of the loop's core
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    {
+      PROF_SCOPE(PROF_BAND);
+      job_fn(job_y0, job_y1, job_ctx);
+    }
+    xSemaphoreGive(done);
+  }
+}
+
+bool band_split_begin(void) {
+  if (!BAND_SPLIT_ENABLE || running) return running;
+  done = xSemaphoreCreateBinary();
+  if (done == NULL) return false;
+  BaseType_t core = 1 - xPortGetCoreID();   // The core the caller does not run on
+  if (xTaskCreatePinnedToCore(worker_task, "band", 2048, NULL, uxTaskPriorityGet(NULL) + 1, &worker, core) != pdPASS) {
+    return false;
+  }
+  running = true;
+  return true;
+}
+
+static void worker_start(void) {
+  xTaskNotifyGive(worker);
+}
+
+static void worker_wait(void) {
+  xSemaphoreTake(done, portMAX_DELAY);
+}
+#else
+// Never destroyed: the worker is still waiting on them when the program exits
+static std::mutex &mtx = *new std::mutex;
+static std::condition_variable &cv = *new std::condition_variable;
+static bool pending, finished;
+
+// Worker thread: wait for a band, render it, signal
+static void worker_thread(void) {
+  prof_sync_core();                       // Band records get a track of their own
+  for (;;) {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [] { return pending; });
+    pending = false;
+    lock.unlock();
+    {
+      PROF_SCOPE(PROF_BAND);
+      job_fn(job_y0, job_y1, job_ctx);
+    }
+    lock.lock();
+    finished = true;
+    cv.notify_all();
+  }
+}
+
+bool band_split_begin(void) {
+  if (!BAND_SPLIT_ENABLE || running) return running;
+  std::thread(worker_thread).detach();
+  running = true;
+  return true;
+}
+
+static void worker_start(void) {
+  std::lock_guard<std::mutex> lock(mtx);
+  finished = false;
+  pending = true;
+  cv.notify_all();
+}
+
+static void worker_wait(void) {
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [] { return finished; });
+}
+#endif
+
+void band_split_set_threshold(uint32_t pixels) {
+  threshold = pixels;
+}
+
+uint32_t band_split_threshold(void) {
+  return threshold;
+}
+
+bool band_split_run(int32_t rows, uint32_t pixels, band_job_t job, void *ctx) {
+  if (!running || rows < 2 || pixels < threshold) {
+    stats.single++;
+    job(0, rows, ctx);
+    return false;
+  }
+
+  int32_t mid = rows / 2;
+  job_fn = job;
+  job_ctx = ctx;
+  job_y0 = 0;
+  job_y1 = mid;
+  worker_start();
+  job(mid, rows, ctx);      // Lower band on this core meanwhile
+  worker_wait();
+  stats.split++;
+  return true;
+}
+
+void band_split_get_stats(band_split_stats_t *out) {
+  *out = stats;
+}
+
+void band_split_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,342 @@
+/*
+ * Boot benchmarks, see boot_bench.h
+ */
+
+#include <math.h>
+#include <string.h>
+#include "boot_bench.h"
+#include "spi_bus.h"
+#include "menu_rows.h"
+#include "rle_img.h"
+#include "band_split.h"
+#include "render_kernels.h"
+#include "lvgl_pool.h"
+
+#ifdef MENU_ICONS
+LV_IMG_DECLARE(icon_item);
+LV_IMG_DECLARE(icon_back);
+LV_IMG_DECLARE(icon_subitem);
+#endif
+
+static const boot_bench_ui_t *ui;
+static bool bypass;                  // Send whole areas, still updating the shadow copy
+static bool probe;                   // Measure the RGB444 error of the flushed pixels
+static rgb444_error_t probe_error;
+
+bool boot_bench_bypass(void) {
+  return bypass;
+}
+
+void boot_bench_flushed(const uint16_t *pixels, uint32_t n, bool solid) {
+  if (!probe) return;
+  if (!solid) {
+    rgb565_error444(pixels, n, LV_COLOR_16_SWAP, &probe_error);
+    return;
+  }
+  rgb444_error_t one = {};
+  rgb565_error444(pixels, 1, LV_COLOR_16_SWAP, &one);
+  probe_error.pixels += n;
+  probe_error.changed += one.changed * n;
+  probe_error.sum_abs += one.sum_abs * n;
+  probe_error.sum_sq += one.sum_sq * n;
+  if (one.max > probe_error.max) probe_error.max = one.max;
+}
+
+// Full-frame flushes with a CPU byte swap and in native byte order
+static void flush_benchmark() {
+  uint32_t frames = FLUSH_BENCH_FRAMES;   // Frames timed per mode
+  for (int mode = 0; mode < 2; mode++) {
+    bool swap = mode == 0;   // First the swapping path, then the native path
+    uint32_t start = micros();
+    for (uint32_t f = 0; f < frames; f++) {
+      for (uint32_t y = 0; y < ui->height; y += ui->buf_rows) {
+        spi_bus_push_pixels(0, y, ui->width, ui->buf_rows, (uint16_t *)ui->draw_buf, swap);
+      }
+    }
+    Serial.printf("flush bench %s: %lu us/frame\n", swap ? "swapped" : "native",
+                  (unsigned long)((micros() - start) / frames));
+  }
+}
+
+// Scrolling through a 10-row list whose rows show their text as labels and as cached label images;
+// every step repaints all rows, as a highlight change does
+static void label_cache_benchmark() {
+  for (int mode = 0; mode < 2; mode++) {
+    lv_obj_t *bench = lv_list_create(lv_scr_act());   // Temporary list on top of the screen
+    for (int i = 0; i < 10; i++) {                     // A menu string, so the subset font has its glyphs
+      if (mode) menu_rows_add_cached(bench, NULL, "SubItem");
+      else menu_rows_add(bench, NULL, "SubItem");
+    }
+    lv_obj_align(bench, LV_ALIGN_CENTER, 0, 0);
+    lv_refr_now(NULL);                                 // Start from a drawn screen
+
+    uint32_t start = micros();
+    for (uint32_t run = 0; run < LABEL_BENCH_RUNS; run++) {
+      for (int i = 0; i < 10; i++) {
+        lv_obj_scroll_to_view(lv_obj_get_child(bench, i), LV_ANIM_OFF);
+        lv_obj_invalidate(bench);
+        lv_refr_now(NULL);
+      }
+    }
+    Serial.printf("label bench %s: %lu us/scroll\n", mode ? "cached" : "labels",
+                  (unsigned long)((micros() - start) / LABEL_BENCH_RUNS));
+    lv_obj_del(bench);
+  }
+
+  // Glyph lookup time of the default font (the generated subset when MENU_FONT_SUBSET is set)
+  static const char text[] = "ItemSubItemReturn";
+  lv_font_glyph_dsc_t g;
+  uint32_t lookups = 0;
+  uint32_t start = micros();
+  for (uint32_t run = 0; run < LABEL_BENCH_RUNS * 100; run++) {
+    for (const char *c = text; *c; c++) {
+      lv_font_get_glyph_dsc(LV_FONT_DEFAULT, &g, *c, 0);
+      lv_font_get_glyph_bitmap(LV_FONT_DEFAULT, *c);
+      lookups++;
+    }
+  }
+#ifdef MENU_FONT_SUBSET
+  const char *font_kind = "subset";
+#else
+  const char *font_kind = "full";
+#endif
+  Serial.printf("glyph lookup %s: %lu ns\n", font_kind,
+                (unsigned long)(lookups ? (micros() - start) * 1000ull / lookups : 0));
+}
+
+// Line-by-line decoding of the menu icons, and their size against raw images
+static void icon_benchmark() {
+#ifdef MENU_ICONS
+  static const lv_img_dsc_t *icons[] = {&icon_item, &icon_back, &icon_subitem};
+  static const char *names[] = {"item", "back", "subitem"};
+  for (int i = 0; i < 3; i++) {
+    const lv_img_dsc_t *img = icons[i];
+    uint32_t w = img->header.w;
+    uint8_t *line = (uint8_t *)malloc(w * LV_IMG_PX_SIZE_ALPHA_BYTE); // One line, as LVGL hands it to the decoder
+    if (line == NULL) return;
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t run = 0; run < ICON_BENCH_RUNS; run++) {
+      for (uint32_t y = 0; y < img->header.h; y++) rle_img_decode_line(img, 0, y, w, line);
+    }
+    uint32_t cycles = ESP.getCycleCount() - start;
+    free(line);
+    uint32_t pixels = ICON_BENCH_RUNS * w * img->header.h;
+    Serial.printf("icon %s %ux%u: %lu bytes (raw %lu bytes), decode %.1f MPix/s\n", names[i],
+                  (unsigned)img->header.w, (unsigned)img->header.h, (unsigned long)img->data_size,
+                  (unsigned long)(img->header.w * img->header.h * LV_IMG_PX_SIZE_ALPHA_BYTE),
+                  cycles ? (float)pixels * ESP.getCpuFreqMHz() / cycles : 0.0f);
+  }
+#else
+  Serial.println("icon bench: no icons (MENU_ICONS not set)");
+#endif
+}
+
+// Full-screen redraws with the band split off and on; SPI time is taken out
+static void band_benchmark() {
+  uint32_t threshold = band_split_threshold();
+  uint32_t runs = BAND_BENCH_RUNS;
+  uint32_t render_us[2];
+  for (int mode = 0; mode < 2; mode++) {
+    band_split_set_threshold(mode ? threshold : UINT32_MAX);
+    spi_bus_reset_stats();
+    uint32_t start = micros();
+    for (uint32_t run = 0; run < runs; run++) {
+      lv_obj_invalidate(lv_scr_act());
+      lv_refr_now(NULL);
+    }
+    spi_bus_stats_t disp_stats;
+    spi_bus_get_stats(SPI_BUS_DISPLAY, &disp_stats);
+    render_us[mode] = (micros() - start - disp_stats.busy_us) / runs;
+  }
+  band_split_set_threshold(threshold);
+  Serial.printf("band bench: render %lu us/frame on one core, %lu us/frame on two (x%.2f)\n",
+                (unsigned long)render_us[0], (unsigned long)render_us[1],
+                render_us[1] ? (float)render_us[0] / render_us[1] : 0.0f);
+}
+
+// Full-screen frames end to end in both transport formats, and the RGB444 error
+static void transport_benchmark() {
+  static const char *const names[2] = {"rgb565", "rgb444"};
+  uint32_t frames = TRANSPORT_BENCH_FRAMES;
+  spi_bus_format_t saved = spi_bus_format();
+  bypass = true;              // The frames repeat: every pixel has to go over the wire
+  for (int mode = 0; mode < 2; mode++) {
+    spi_bus_set_format(mode ? SPI_BUS_RGB444 : SPI_BUS_RGB565);
+    spi_bus_reset_stats();
+    memset(&probe_error, 0, sizeof(probe_error));
+    probe = mode == 1;
+    uint32_t start = micros();
+    for (uint32_t run = 0; run < frames; run++) {
+      lv_obj_invalidate(lv_scr_act());
+      lv_refr_now(NULL);
+    }
+    uint32_t us = micros() - start;
+    probe = false;
+
+    spi_bus_stats_t disp_stats;
+    spi_bus_get_stats(SPI_BUS_DISPLAY, &disp_stats);
+    Serial.printf("transport %s: %lu us/frame, %lu bytes/frame\n", names[mode], (unsigned long)(us / frames),
+                  (unsigned long)(disp_stats.bytes / frames));
+  }
+  spi_bus_set_format(saved);
+  bypass = false;
+
+  // Error of the 12-bit frames against what RGB565 shows, per 8-bit channel
+  const rgb444_error_t *e = &probe_error;
+  float mse = e->pixels ? (float)e->sum_sq / (3.0f * e->pixels) : 0.0f;
+  Serial.printf("transport rgb444 error: mean=%.2f max=%u psnr=%.1f dB changed=%.1f%%\n",
+                e->pixels ? (float)e->sum_abs / (3.0f * e->pixels) : 0.0f, (unsigned)e->max,
+                mse > 0 ? 10.0f * log10f(255.0f * 255.0f / mse) : 99.0f,
+                e->pixels ? 100.0f * e->changed / e->pixels : 0.0f);
+}
+
+// Open and close the sublist many times and compare the LVGL pool before and after
+static void pool_soak() {
+  ui->open_page(0);                   // The page arena is taken from the pool on first use
+  ui->close_page();
+  lv_refr_now(NULL);                  // Settle the first frame's allocations
+  lvgl_pool_mon_t before, after;
+  lvgl_pool_monitor(&before);
+
+  for (uint32_t i = 0; i < SOAK_CYCLES; i++) {
+    ui->open_page(i % ui->items);
+    if (i % 64 == 0) {
+      lv_refr_now(NULL);              // Render now and then so draw-time allocations are churned too
+    }
+    ui->close_page();
+  }
+  lv_refr_now(NULL);
+  lvgl_pool_monitor(&after);
+
+  bool ok = after.used == before.used && after.blocks == before.blocks;
+  Serial.printf("pool soak %lu cycles: used %lu -> %lu, blocks %lu -> %lu, frag %u%% -> %u%%: %s\n",
+                (unsigned long)SOAK_CYCLES, (unsigned long)before.used, (unsigned long)after.used,
+                (unsigned long)before.blocks, (unsigned long)after.blocks, (unsigned)before.frag_pct,
+                (unsigned)after.frag_pct, ok ? "PASS" : "FAIL");
+}
+
+// Sublist open/close cycles with the page arena off and on, and the pool state after each
+static void arena_benchmark() {
+  bool saved = *ui->page_arena;
+  uint32_t cycles = ARENA_BENCH_CYCLES;
+  for (int mode = 0; mode < 2; mode++) {
+    *ui->page_arena = mode == 1;
+    ui->open_page(0);                 // Warm up (and take the arena from the pool)
+    ui->close_page();
+    lv_refr_now(NULL);
+
+    uint32_t open_us = 0, close_us = 0;
+    for (uint32_t i = 0; i < cycles; i++) {
+      uint32_t t0 = micros();
+      ui->open_page(i % ui->items);
+      uint32_t t1 = micros();
+      if (i % 16 == 0) {
+        lv_refr_now(NULL);            // Interleave render-time allocations with the pages
+      }
+      uint32_t t2 = micros();
+      ui->close_page();
+      close_us += micros() - t2;
+      open_us += t1 - t0;
+    }
+    lv_refr_now(NULL);
+
+    lvgl_pool_mon_t mon;
+    lvgl_pool_monitor(&mon);
+    Serial.printf("arena %s: open=%lu us close=%lu us used=%lu biggest=%lu frag=%u%% min_free=%lu\n",
+                  mode ? "on " : "off", (unsigned long)(open_us / cycles),
+                  (unsigned long)(close_us / cycles), (unsigned long)mon.used,
+                  (unsigned long)mon.biggest_free, (unsigned)mon.frag_pct, (unsigned long)mon.min_free);
+  }
+  *ui->page_arena = saved;
+
+  lvgl_arena_stats_t arena;
+  lvgl_arena_get_stats(&arena);
+  Serial.printf("arena size=%lu peak=%lu overflows=%lu live=%lu\n", (unsigned long)arena.size,
+                (unsigned long)arena.peak, (unsigned long)arena.overflows, (unsigned long)arena.live);
+}
+
+// Click handlers of the row benchmark: the index comes from user data (per-row callback) or from the list
+static volatile int32_t bench_clicked;
+static void bench_row_clicked(lv_event_t *e) {
+  bench_clicked = (int32_t)(intptr_t)lv_event_get_user_data(e);
+}
+static void bench_list_clicked(lv_event_t *e) {
+  lv_obj_t *obj = lv_event_get_target(e);
+  bench_clicked = lv_obj_get_parent(obj) == lv_event_get_current_target(e) ? (int32_t)lv_obj_get_index(obj) : -1;
+}
+
+// Fill a temporary list in three ways and print the pool bytes per row and the time to dispatch a click
+// on its last row: copied text with a callback per row (the original menu), static text with a callback
+// per row, and static text with one callback on the list. Rows are added while the pool keeps a reserve,
+// so a large list reports how many rows fit.
+static void row_ram_benchmark() {
+  static const uint32_t sizes[] = {5, 100, 1000};
+  static const char *const modes[] = {"copied+cb", "static+cb", "static+list"};
+  const uint32_t reserve = 4096;      // Left free for LVGL to keep drawing
+  const uint32_t clicks = 100;
+  bool saved = *ui->lean_rows;
+  for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (int mode = 0; mode < 3; mode++) {
+      *ui->lean_rows = mode != 0;
+      bool per_row = mode != 2;
+      lvgl_pool_mon_t before, after;
+      lvgl_pool_monitor(&before);
+      lv_obj_t *bench = lv_list_create(lv_scr_act());
+      lv_obj_add_flag(bench, LV_OBJ_FLAG_HIDDEN);     // Never drawn
+      if (!per_row) lv_obj_add_event_cb(bench, bench_list_clicked, LV_EVENT_CLICKED, NULL);
+      lvgl_pool_monitor(&after);
+      uint32_t base = after.used, rows = 0;
+      lv_obj_t *last = NULL;
+      while (rows < sizes[s] && after.biggest_free > reserve) {
+        last = ui->add_row(bench, ui->row_icon, "Item");
+        if (per_row) lv_obj_add_event_cb(last, bench_row_clicked, LV_EVENT_CLICKED, (void *)(intptr_t)rows);
+        if (rows == 0) lv_obj_add_style(last, ui->selected_style, 0); // One highlighted row, as in the menu
+        rows++;
+        lvgl_pool_monitor(&after);
+      }
+
+      uint32_t start = micros();
+      for (uint32_t i = 0; last && i < clicks; i++) {
+        lv_event_send(last, LV_EVENT_CLICKED, NULL);
+      }
+      float click_us = (float)(micros() - start) / clicks;
+
+      Serial.printf("rows %4lu %-11s: fit=%lu bytes/row=%lu (list %lu B) click=%.2f us%s\n",
+                    (unsigned long)sizes[s], modes[mode], (unsigned long)rows,
+                    (unsigned long)(rows ? (after.used - base) / rows : 0), (unsigned long)(base - before.used),
+                    click_us, bench_clicked == (int32_t)rows - 1 ? "" : " WRONG ROW");
+      lv_obj_del(bench);
+    }
+  }
+  *ui->lean_rows = saved;
+}
+
+void boot_bench_run(const boot_bench_ui_t *menu) {
+  if (!BOOT_BENCH) return;
+  ui = menu;
+  if (FLUSH_BENCH_FRAMES) {
+    flush_benchmark();        // Flush time per frame for both byte orders
+  }
+  if (LABEL_BENCH_RUNS) {
+    label_cache_benchmark();  // List scroll render time with and without the label cache
+  }
+  if (ICON_BENCH_RUNS) {
+    icon_benchmark();         // Decode throughput and flash size of the menu icons
+  }
+  if (BAND_BENCH_RUNS) {
+    band_benchmark();         // Speedup of full-screen redraws with the second core
+  }
+  if (TRANSPORT_BENCH_FRAMES) {
+    transport_benchmark();    // Frame time and visual error of the RGB444 transport
+  }
+  if (SOAK_CYCLES) {
+    pool_soak();              // Menu churn must leave the LVGL pool as it found it
+  }
+  if (ARENA_BENCH_CYCLES) {
+    arena_benchmark();        // Page open/close time and pool state with and without the arena
+  }
+  if (ROW_RAM_BENCH) {
+    row_ram_benchmark();      // RAM per list row and click dispatch with per-row and with list callbacks
+  }
+  ui = NULL;
+}
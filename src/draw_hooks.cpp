@@ -0,0 +1,308 @@
+/*
+ * LVGL draw hooks, see draw_hooks.h
+ */
+
+#include "draw_hooks.h"
+#include "render_kernels.h"
+#include "band_split.h"
+
+static draw_kernel_stats_t kernel_stats[DRAW_KERNELS];   // Per-kernel accounting
+static uint32_t fallbacks;                                // Blends left to LVGL
+static uint32_t mismatches;                               // Verification failures
+
+// Full-buffer solid fill that has not been written into the buffer yet
+static struct {
+  bool active;
+  void *buf;
+  lv_area_t area;
+  lv_color_t color;
+} solid;
+static lv_draw_layer_ctx_t *(*sw_layer_init)(lv_draw_ctx_t *, lv_draw_layer_ctx_t *, lv_draw_layer_flags_t);
+static void (*sw_buffer_copy)(lv_draw_ctx_t *, void *, lv_coord_t, const lv_area_t *, void *, lv_coord_t,
+                              const lv_area_t *);
+
+// Colour and opacity of a solid blend, mirroring LVGL's fill_normal()
+typedef struct {
+  uint16_t premult[3];
+  lv_opa_t opa_inv;
+} blend_ctx_t;
+
+// Blend result for one background pixel, computed exactly as LVGL does
+static uint16_t mix_premult(uint16_t bg, void *ctx) {
+  blend_ctx_t *c = (blend_ctx_t *)ctx;
+  lv_color_t bg_color;
+  bg_color.full = bg;
+  return lv_color_mix_premult(c->premult, bg_color, c->opa_inv).full;
+}
+
+// One kernel call, run in row bands by band_split_run()
+typedef struct {
+  draw_kernel_t kernel;
+  uint16_t *dest;
+  int32_t dest_stride;
+  int32_t w;
+  uint16_t color;               // Fill colour
+  const uint16_t *src;          // Copy source
+  int32_t src_stride;
+  blend_ctx_t *blend;           // Blend colour and opacity
+  uint16_t seed_bg, seed_res;
+} kernel_job_t;
+
+// Band job: run the kernel on rows y0..y1-1 of the area
+static void kernel_band(int32_t y0, int32_t y1, void *p) {
+  const kernel_job_t *j = (const kernel_job_t *)p;
+  uint16_t *dest = j->dest + y0 * j->dest_stride;
+  switch (j->kernel) {
+    case DRAW_KERNEL_FILL:
+      rgb565_fill(dest, j->dest_stride, j->w, y1 - y0, j->color);
+      break;
+    case DRAW_KERNEL_COPY:
+      rgb565_copy(dest, j->dest_stride, j->src + y0 * j->src_stride, j->src_stride, j->w, y1 - y0);
+      break;
+    default:
+      rgb565_blend_color(dest, j->dest_stride, j->w, y1 - y0, mix_premult, j->blend, j->seed_bg, j->seed_res);
+      break;
+  }
+}
+
+// Run a kernel over h rows, on both cores when the area is above the break-even size
+static void kernel_run(kernel_job_t *j, int32_t h) {
+  band_split_run(h, j->w * h, kernel_band, j);
+}
+
+// Account the pixels and cycles of one kernel call
+static void account(draw_kernel_t kernel, uint32_t pixels, uint32_t start_cycles) {
+  draw_kernel_stats_t *s = &kernel_stats[kernel];
+  s->calls++;
+  s->pixels += pixels;
+  s->cycles += ESP.getCycleCount() - start_cycles;
+}
+
+// Write a deferred solid fill into its buffer before anything reads or draws over it
+static void solid_materialise(void) {
+  if (!solid.active) return;
+  int32_t w = lv_area_get_width(&solid.area);
+  int32_t h = lv_area_get_height(&solid.area);
+  uint32_t start = ESP.getCycleCount();
+  kernel_job_t j = {DRAW_KERNEL_FILL, (uint16_t *)solid.buf, w, w, solid.color.full};
+  kernel_run(&j, h);
+  account(DRAW_KERNEL_FILL, w * h, start);
+  solid.active = false;
+}
+
+// Layers snapshot and blend back the draw buffer, so it has to hold real pixels
+static lv_draw_layer_ctx_t *layer_init_hook(lv_draw_ctx_t *draw_ctx, lv_draw_layer_ctx_t *layer_ctx,
+                                            lv_draw_layer_flags_t flags) {
+  solid_materialise();
+  return sw_layer_init(draw_ctx, layer_ctx, flags);
+}
+
+// Buffer copies read the draw buffer directly
+static void buffer_copy_hook(lv_draw_ctx_t *draw_ctx, void *dest_buf, lv_coord_t dest_stride,
+                             const lv_area_t *dest_area, void *src_buf, lv_coord_t src_stride,
+                             const lv_area_t *src_area) {
+  solid_materialise();
+  sw_buffer_copy(draw_ctx, dest_buf, dest_stride, dest_area, src_buf, src_stride, src_area);
+}
+
+// Fast path for one blend; returns false when the case is left to LVGL
+static bool blend_fast(const lv_draw_sw_blend_dsc_t *dsc, uint16_t *dest, int32_t dest_stride,
+                       const lv_area_t *blend_area) {
+  int32_t w = lv_area_get_width(blend_area);
+  int32_t h = lv_area_get_height(blend_area);
+  uint32_t start = ESP.getCycleCount();
+
+  if (dsc->src_buf == NULL) {
+    if (dsc->opa >= LV_OPA_MAX) {
+      kernel_job_t j = {DRAW_KERNEL_FILL, dest, dest_stride, w, dsc->color.full};  // Row backgrounds, selected row fill
+      kernel_run(&j, h);
+      account(DRAW_KERNEL_FILL, w * h, start);
+      return true;
+    }
+
+    // Same seed and opacity rounding as LVGL so the result is bit-exact
+    lv_opa_t opa = dsc->opa;
+    lv_color_t seed_res = lv_color_mix(dsc->color, lv_color_black(), opa);
+#if LV_COLOR_MIX_ROUND_OFS == 0 && LV_COLOR_DEPTH == 16
+    opa = (uint32_t)((uint32_t)opa + 4) >> 3;
+    opa = opa << 3;
+#endif
+    blend_ctx_t ctx;
+    lv_color_premult(dsc->color, opa, ctx.premult);
+    ctx.opa_inv = 255 - opa;
+
+    kernel_job_t j = {DRAW_KERNEL_BLEND, dest, dest_stride, w, 0, NULL, 0, &ctx, lv_color_black().full, seed_res.full};
+    kernel_run(&j, h);
+    account(DRAW_KERNEL_BLEND, w * h, start);
+    return true;
+  }
+
+  if (dsc->opa >= LV_OPA_MAX) {
+    int32_t src_stride = lv_area_get_width(dsc->blend_area);
+    const uint16_t *src = (const uint16_t *)dsc->src_buf + src_stride * (blend_area->y1 - dsc->blend_area->y1) +
+                          (blend_area->x1 - dsc->blend_area->x1);
+    kernel_job_t j = {DRAW_KERNEL_COPY, dest, dest_stride, w, 0, src, src_stride};
+    kernel_run(&j, h);
+    account(DRAW_KERNEL_COPY, w * h, start);
+    return true;
+  }
+
+  return false;   // Image with opacity: rare in the menu, use the reference
+}
+
+#if DRAW_HOOKS_VERIFY
+// Compare the fast result with the reference blender on the same input
+static void blend_verify(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc, uint16_t *dest,
+                         int32_t dest_stride, const lv_area_t *blend_area) {
+  int32_t w = lv_area_get_width(blend_area);
+  int32_t h = lv_area_get_height(blend_area);
+  uint32_t row_bytes = w * sizeof(uint16_t);
+  uint16_t *before = (uint16_t *)lv_mem_buf_get(row_bytes * h);
+  uint16_t *fast = (uint16_t *)lv_mem_buf_get(row_bytes * h);
+
+  for (int32_t y = 0; y < h; y++) memcpy(before + y * w, dest + y * dest_stride, row_bytes);
+  bool handled = blend_fast(dsc, dest, dest_stride, blend_area);
+  for (int32_t y = 0; y < h; y++) {
+    memcpy(fast + y * w, dest + y * dest_stride, row_bytes);
+    memcpy(dest + y * dest_stride, before + y * w, row_bytes);   // Restore the input
+  }
+
+  lv_draw_sw_blend_basic(draw_ctx, dsc);   // Reference result stays in the buffer
+  if (!handled) fallbacks++;
+  for (int32_t y = 0; handled && y < h; y++) {
+    if (memcmp(fast + y * w, dest + y * dest_stride, row_bytes) != 0) {
+      mismatches++;
+      break;
+    }
+  }
+
+  lv_mem_buf_release(fast);
+  lv_mem_buf_release(before);
+}
+#endif
+
+// Blend callback installed in the software draw context
+static void draw_hooks_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc) {
+#if DRAW_HOOKS_DIRECT_FILL
+  // An opaque fill over the whole buffer replaces whatever was there: just remember its colour
+  if (dsc->src_buf == NULL && dsc->opa >= LV_OPA_MAX && dsc->blend_mode == LV_BLEND_MODE_NORMAL &&
+      (dsc->mask_buf == NULL || dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER)) {
+    lv_area_t covered;
+    const lv_area_t *ba = draw_ctx->buf_area;
+    if (_lv_area_intersect(&covered, dsc->blend_area, draw_ctx->clip_area) && covered.x1 == ba->x1 &&
+        covered.y1 == ba->y1 && covered.x2 == ba->x2 && covered.y2 == ba->y2 &&
+        _lv_refr_get_disp_refreshing()->driver->set_px_cb == NULL) {
+      if (draw_ctx->wait_for_finish) draw_ctx->wait_for_finish(draw_ctx);
+      solid.active = true;
+      solid.buf = draw_ctx->buf;
+      solid.area = *ba;
+      solid.color = dsc->color;
+      return;
+    }
+  }
+  solid_materialise();   // Anything else needs the real background underneath
+#endif
+
+  // Masks (text, rounded corners, anti-aliasing) and special blend modes go to LVGL
+  if ((dsc->mask_buf && dsc->mask_res != LV_DRAW_MASK_RES_FULL_COVER) ||
+      dsc->blend_mode != LV_BLEND_MODE_NORMAL || dsc->opa <= LV_OPA_MIN) {
+    fallbacks++;
+    lv_draw_sw_blend_basic(draw_ctx, dsc);
+    return;
+  }
+
+  lv_area_t blend_area;
+  if (!_lv_area_intersect(&blend_area, dsc->blend_area, draw_ctx->clip_area)) return;
+
+  lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+  if (disp->driver->set_px_cb) {
+    fallbacks++;
+    lv_draw_sw_blend_basic(draw_ctx, dsc);
+    return;
+  }
+
+  if (draw_ctx->wait_for_finish) draw_ctx->wait_for_finish(draw_ctx);
+
+  int32_t dest_stride = lv_area_get_width(draw_ctx->buf_area);
+  uint16_t *dest = (uint16_t *)draw_ctx->buf + dest_stride * (blend_area.y1 - draw_ctx->buf_area->y1) +
+                   (blend_area.x1 - draw_ctx->buf_area->x1);
+
+#if DRAW_HOOKS_VERIFY
+  blend_verify(draw_ctx, dsc, dest, dest_stride, &blend_area);
+#else
+  if (!blend_fast(dsc, dest, dest_stride, &blend_area)) {
+    fallbacks++;
+    lv_draw_sw_blend_basic(draw_ctx, dsc);
+  }
+#endif
+}
+
+void draw_hooks_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx) {
+  lv_draw_sw_init_ctx(drv, draw_ctx);                   // Standard software renderer
+  ((lv_draw_sw_ctx_t *)draw_ctx)->blend = draw_hooks_blend;
+
+#if DRAW_HOOKS_DIRECT_FILL
+  sw_layer_init = draw_ctx->layer_init;                 // Keep the software implementations to chain to
+  sw_buffer_copy = draw_ctx->buffer_copy;
+  draw_ctx->layer_init = layer_init_hook;
+  draw_ctx->buffer_copy = buffer_copy_hook;
+#endif
+}
+
+bool draw_hooks_take_solid(const void *buf, lv_color_t *color) {
+  if (!solid.active || solid.buf != buf) return false;
+  *color = solid.color;
+  solid.active = false;   // The buffer is handed back to LVGL after the flush
+  return true;
+}
+
+uint32_t draw_hooks_calibrate_split(uint16_t *buf, int32_t w, int32_t max_rows, uint32_t repeat) {
+  uint32_t saved = band_split_threshold();
+  uint32_t threshold = UINT32_MAX;   // Smallest area from which the split stays faster
+
+  for (int32_t rows = max_rows; rows >= 2; rows--) {
+    kernel_job_t j = {DRAW_KERNEL_FILL, buf, w, w, 0};
+    uint32_t cycles[2];
+    for (int mode = 0; mode < 2; mode++) {
+      band_split_set_threshold(mode ? 0 : UINT32_MAX);
+      uint32_t start = ESP.getCycleCount();
+      for (uint32_t r = 0; r < repeat; r++) kernel_run(&j, rows);
+      cycles[mode] = ESP.getCycleCount() - start;
+    }
+    if (cycles[1] >= cycles[0]) break;
+    threshold = w * rows;
+  }
+
+  band_split_set_threshold(saved);
+  return threshold;
+}
+
+void draw_hooks_get_stats(draw_kernel_t kernel, draw_kernel_stats_t *out) {
+  *out = kernel_stats[kernel];
+}
+
+uint32_t draw_hooks_fallbacks(void) {
+  return fallbacks;
+}
+
+uint32_t draw_hooks_mismatches(void) {
+  return mismatches;
+}
+
+void draw_hooks_reset_stats(void) {
+  memset(kernel_stats, 0, sizeof(kernel_stats));
+  fallbacks = 0;
+}
+
+void draw_hooks_report(Print &out) {
+  static const char *const names[DRAW_KERNELS] = {"fill", "copy", "blend"};
+  uint32_t mhz = ESP.getCpuFreqMHz();
+
+  for (int i = 0; i < DRAW_KERNELS; i++) {
+    const draw_kernel_stats_t *s = &kernel_stats[i];
+    float us = (float)s->cycles / mhz;
+    out.printf("draw %-5s calls=%lu px=%lu mpix/s=%.1f\n", names[i], (unsigned long)s->calls,
+               (unsigned long)s->pixels, us > 0 ? s->pixels / us : 0.0f);
+  }
+  out.printf("draw fallbacks=%lu mismatches=%lu\n", (unsigned long)fallbacks, (unsigned long)mismatches);
+}
@@ -0,0 +1,88 @@
+/*
+ * Rotary encoder input, see encoder.h
+ */
+
+#include <Arduino.h>
+#include "encoder.h"
+
+static uint8_t enc_pin_a, enc_pin_b;              // Encoder pins
+static uint8_t enc_last_a;                        // Last level seen on pin A
+static volatile int32_t enc_delta;                // Net steps not yet consumed by the UI
+static volatile uint32_t enc_total;               // Steps decoded since boot
+static volatile uint32_t enc_first_us;            // Time of the oldest pending step
+static volatile bool enc_pending;                 // Steps arrived since the last take
+static portMUX_TYPE enc_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t enc_waiter;                   // Task sleeping in encoder_wait()
+
+// Wake the task sleeping in encoder_wait()
+static void IRAM_ATTR encoder_wake_from_isr() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(enc_waiter, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// Edge interrupt of an extra wake pin
+static void IRAM_ATTR encoder_wake_isr() {
+  encoder_wake_from_isr();
+}
+
+// Pin A edge interrupt: decode the step and add it to the pending delta
+static void IRAM_ATTR encoder_isr() {
+  int8_t step = encoder_decode(&enc_last_a, digitalRead(enc_pin_a), digitalRead(enc_pin_b));
+  if (step) {
+    uint32_t now = micros();
+    portENTER_CRITICAL_ISR(&enc_mux);
+    if (!enc_pending) {
+      enc_first_us = now;   // Latency of this batch is measured from its first edge
+      enc_pending = true;
+    }
+    enc_delta += step;
+    enc_total++;
+    portEXIT_CRITICAL_ISR(&enc_mux);
+    encoder_wake_from_isr();
+  }
+}
+
+void encoder_begin(uint8_t pin_a, uint8_t pin_b) {
+  enc_pin_a = pin_a;
+  enc_pin_b = pin_b;
+  pinMode(pin_a, INPUT_PULLUP);             // Set pin A as input
+  pinMode(pin_b, INPUT_PULLUP);             // Set pin B as input
+  enc_last_a = digitalRead(pin_a);          // Initialize the last state of encoder pin A
+  enc_waiter = xTaskGetCurrentTaskHandle(); // The task calling encoder_begin() is the one that waits
+  attachInterrupt(digitalPinToInterrupt(pin_a), encoder_isr, CHANGE);
+}
+
+void encoder_wake_on_pin(uint8_t pin) {
+  attachInterrupt(digitalPinToInterrupt(pin), encoder_wake_isr, FALLING);
+}
+
+bool encoder_wait(uint32_t timeout_ms) {
+  return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) != 0;
+}
+
+int32_t encoder_take_delta(uint32_t *first_us) {
+  portENTER_CRITICAL(&enc_mux);
+  int32_t delta = enc_delta;
+  if (first_us) *first_us = enc_first_us;
+  enc_delta = 0;
+  enc_pending = false;
+  portEXIT_CRITICAL(&enc_mux);
+  return delta;
+}
+
+void encoder_inject(int32_t steps) {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&enc_mux);
+  if (!enc_pending) {
+    enc_first_us = now;
+    enc_pending = true;
+  }
+  enc_delta += steps;
+  enc_total += steps < 0 ? -steps : steps;
+  portEXIT_CRITICAL(&enc_mux);
+}
+
+uint32_t encoder_total_steps(void) {
+  return enc_total;
+}
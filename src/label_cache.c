@@ -0,0 +1,223 @@
+/*
+ * Label bitmap cache, see label_cache.h
+ */
+
+#include <string.h>
+#include "label_cache.h"
+
+#define NO_SPACE UINT32_MAX
+#define ALPHA_AT (LV_IMG_PX_SIZE_ALPHA_BYTE - 1)   // Alpha byte after the colour of a pixel
+
+// One cached image; the pixels and then a copy of the text sit in the store
+typedef struct {
+  lv_img_dsc_t img;         // First member, so an image pointer is its entry
+  const lv_font_t *font;
+  lv_color_t color;
+  uint32_t hash;            // Of the text
+  uint32_t offset;          // Start in the store
+  uint32_t bytes;           // Pixels and text, rounded up to 4
+  uint32_t last_use;        // LRU clock of the last get
+  uint16_t refs;            // Images showing it; pinned while non-zero
+  bool used;
+} label_entry_t;
+
+static label_entry_t entries[LABEL_CACHE_ENTRIES];
+static uint8_t store[LABEL_CACHE_BYTES] __attribute__((aligned(4)));
+static uint32_t use_clock;
+static label_cache_stats_t stats;
+
+// FNV-1a of the text
+static uint32_t text_hash(const char *text) {
+  uint32_t h = 2166136261u;
+  while (*text) h = (h ^ (uint8_t)*text++) * 16777619u;
+  return h;
+}
+
+static const char *entry_text(const label_entry_t *e) {
+  return (const char *)e->img.data + e->img.data_size;
+}
+
+// First offset where size bytes fit between the live entries, NO_SPACE if none
+static uint32_t find_space(uint32_t size) {
+  uint32_t pos = 0;
+  bool moved = true;
+  while (moved) {
+    if (pos + size > LABEL_CACHE_BYTES) return NO_SPACE;
+    moved = false;
+    for (uint32_t i = 0; i < LABEL_CACHE_ENTRIES; i++) {
+      const label_entry_t *e = &entries[i];
+      if (e->used && e->offset < pos + size && e->offset + e->bytes > pos) {
+        pos = e->offset + e->bytes;   // Overlaps: try right after it
+        moved = true;
+      }
+    }
+  }
+  return pos;
+}
+
+static void evict(label_entry_t *e) {
+  lv_img_cache_invalidate_src(&e->img);   // The next image in this slot is a different one
+  e->used = false;
+  stats.bytes -= e->bytes;
+  stats.entries--;
+  stats.evictions++;
+}
+
+// Least recently used entry that no image shows, NULL if all are pinned
+static label_entry_t *lru_victim(void) {
+  label_entry_t *victim = NULL;
+  for (uint32_t i = 0; i < LABEL_CACHE_ENTRIES; i++) {
+    label_entry_t *e = &entries[i];
+    if (e->used && e->refs == 0 && (victim == NULL || (int32_t)(e->last_use - victim->last_use) < 0)) {
+      victim = e;
+    }
+  }
+  return victim;
+}
+
+// Merge one glyph's coverage into the alpha bytes of the image, placed like lv_draw_letter() does
+static void draw_glyph(uint8_t *px, int32_t w, int32_t h, int32_t x0, int32_t y0,
+                       const lv_font_glyph_dsc_t *g, const uint8_t *map) {
+  uint32_t bpp = g->bpp == 3 ? 4 : g->bpp;    // 3 bpp fonts are unpacked to 4
+  uint32_t mask = (1u << bpp) - 1;
+  uint32_t scale = 255 / mask;
+  uint32_t bit = 0;                            // Glyph rows are packed without padding, MSB first
+  for (int32_t y = 0; y < g->box_h; y++) {
+    for (int32_t x = 0; x < g->box_w; x++, bit += bpp) {
+      int32_t tx = x0 + x, ty = y0 + y;
+      if (tx < 0 || tx >= w || ty < 0 || ty >= h) continue;
+      uint8_t a = (uint8_t)(((map[bit >> 3] >> (8 - bpp - (bit & 7))) & mask) * scale);
+      uint8_t *p = &px[(ty * w + tx) * LV_IMG_PX_SIZE_ALPHA_BYTE + ALPHA_AT];
+      if (a > *p) *p = a;
+    }
+  }
+}
+
+// Text colour in every pixel, the glyph coverage as alpha
+static void render(uint8_t *px, int32_t w, int32_t h, const char *text, const lv_font_t *font, lv_color_t color) {
+  for (int32_t i = 0; i < w * h; i++) {
+    memcpy(&px[i * LV_IMG_PX_SIZE_ALPHA_BYTE], &color, sizeof(color));
+    px[i * LV_IMG_PX_SIZE_ALPHA_BYTE + ALPHA_AT] = 0;
+  }
+
+  int32_t base = font->line_height - font->base_line;   // Baseline from the top of the line
+  int32_t pen = 0;
+  uint32_t i = 0;
+  uint32_t letter = _lv_txt_encoded_next(text, &i);
+  while (letter) {
+    uint32_t next = _lv_txt_encoded_next(text, &i);
+    lv_font_glyph_dsc_t g = {0};
+    if (lv_font_get_glyph_dsc(font, &g, letter, next) && g.box_w && g.box_h) {
+      const lv_font_t *from = g.resolved_font ? g.resolved_font : font;   // Fallback fonts
+      const uint8_t *map = lv_font_get_glyph_bitmap(from, letter);
+      if (map) draw_glyph(px, w, h, pen + g.ofs_x, base - g.box_h - g.ofs_y, &g, map);
+    }
+    pen += g.adv_w;   // Also set for missing glyphs, as lv_txt_get_width() counts them
+    letter = next;
+  }
+}
+
+const lv_img_dsc_t *label_cache_get(const char *text, const lv_font_t *font, lv_color_t color) {
+  uint32_t hash = text_hash(text);
+  use_clock++;
+  for (uint32_t i = 0; i < LABEL_CACHE_ENTRIES; i++) {
+    label_entry_t *e = &entries[i];
+    if (e->used && e->hash == hash && e->font == font && e->color.full == color.full &&
+        strcmp(entry_text(e), text) == 0) {
+      stats.hits++;
+      e->refs++;
+      e->last_use = use_clock;
+      return &e->img;
+    }
+  }
+
+  stats.misses++;
+  int32_t w = lv_txt_get_width(text, strlen(text), font, 0, LV_TEXT_FLAG_NONE);
+  int32_t h = lv_font_get_line_height(font);
+  uint32_t pixel_bytes = (uint32_t)(w * h) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+  uint32_t bytes = (pixel_bytes + strlen(text) + 1 + 3) & ~3u;
+  if (w <= 0 || h <= 0 || w > 2047 || h > 2047 || bytes > LABEL_CACHE_BYTES) {
+    stats.bypass++;   // Empty, or larger than the image header or the whole budget
+    return NULL;
+  }
+
+  // A free slot and a gap in the store, evicting the least recently used images until both exist
+  label_entry_t *e;
+  uint32_t offset;
+  for (;;) {
+    e = NULL;
+    for (uint32_t i = 0; i < LABEL_CACHE_ENTRIES && e == NULL; i++) {
+      if (!entries[i].used) e = &entries[i];
+    }
+    offset = e ? find_space(bytes) : NO_SPACE;
+    if (offset != NO_SPACE) break;
+    label_entry_t *victim = lru_victim();
+    if (victim == NULL) {
+      stats.bypass++;
+      return NULL;
+    }
+    evict(victim);
+  }
+
+  uint8_t *px = &store[offset];
+  render(px, w, h, text, font, color);
+  memcpy(px + pixel_bytes, text, strlen(text) + 1);
+
+  memset(&e->img, 0, sizeof(e->img));
+  e->img.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+  e->img.header.w = w;
+  e->img.header.h = h;
+  e->img.data_size = pixel_bytes;
+  e->img.data = px;
+  e->font = font;
+  e->color = color;
+  e->hash = hash;
+  e->offset = offset;
+  e->bytes = bytes;
+  e->last_use = use_clock;
+  e->refs = 1;
+  e->used = true;
+
+  stats.bytes += bytes;
+  if (stats.bytes > stats.peak_bytes) stats.peak_bytes = stats.bytes;
+  stats.entries++;
+  return &e->img;
+}
+
+void label_cache_release(const lv_img_dsc_t *img) {
+  label_entry_t *e = (label_entry_t *)img;
+  if (e >= entries && e < entries + LABEL_CACHE_ENTRIES && e->refs) e->refs--;
+}
+
+// LV_EVENT_DELETE of a cached label: the image may be evicted from now on
+static void release_on_delete(lv_event_t *e) {
+  label_cache_release((const lv_img_dsc_t *)lv_event_get_user_data(e));
+}
+
+lv_obj_t *label_cache_create(lv_obj_t *parent, const char *text) {
+  const lv_font_t *font = lv_obj_get_style_text_font(parent, LV_PART_MAIN);
+  lv_color_t color = lv_obj_get_style_text_color(parent, LV_PART_MAIN);
+  const lv_img_dsc_t *img = label_cache_get(text, font, color);
+  if (img == NULL) return NULL;
+  lv_obj_t *obj = lv_img_create(parent);
+  lv_img_set_src(obj, img);
+  lv_obj_add_event_cb(obj, release_on_delete, LV_EVENT_DELETE, (void *)img);
+  return obj;
+}
+
+void label_cache_clear(void) {
+  for (uint32_t i = 0; i < LABEL_CACHE_ENTRIES; i++) {
+    if (entries[i].used && entries[i].refs == 0) evict(&entries[i]);
+  }
+}
+
+void label_cache_get_stats(label_cache_stats_t *out) {
+  *out = stats;
+}
+
+void label_cache_reset_stats(void) {
+  uint32_t bytes = stats.bytes, entries_used = stats.entries;
+  memset(&stats, 0, sizeof(stats));
+  stats.bytes = stats.peak_bytes = bytes;   // Occupancy is state, not a counter
+  stats.entries = entries_used;
+}
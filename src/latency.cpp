@@ -0,0 +1,118 @@
+/*
+ * Input-to-photon latency, see latency.h
+ */
+
+#include <string.h>
+#include "latency.h"
+
+// Input waiting for the frame that displays it
+typedef struct {
+  uint32_t input_us;
+  uint32_t frame;         // Frame the tag is bound to (0 = not bound yet)
+  uint8_t src;
+} latency_tag_t;
+
+static latency_tag_t pending[LATENCY_PENDING_MAX];   // Tags not yet displayed
+static uint8_t pending_count;
+static uint32_t frame_id;                             // Id of the latest frame that started rendering
+static uint32_t histogram[LATENCY_BUCKETS];          // Log-linear latency histogram
+static uint32_t total, worst;                         // Records and worst latency since reset
+static latency_record_t records[LATENCY_RECORDS];    // Ring of recent records
+static uint32_t record_head;                          // Records written since boot
+
+// Histogram bucket of a latency: exact below 8us, then 8 buckets per power of two
+static uint32_t bucket_of(uint32_t v) {
+  if (v < (1u << LATENCY_SUB_BITS)) return v;
+  uint32_t e = 31 - __builtin_clz(v);
+  uint32_t sub = (v >> (e - LATENCY_SUB_BITS)) & ((1u << LATENCY_SUB_BITS) - 1);
+  return ((e - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+}
+
+// Largest latency that falls into a bucket
+static uint32_t bucket_upper(uint32_t idx) {
+  if (idx < (1u << LATENCY_SUB_BITS)) return idx;
+  uint32_t e = (idx >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+  uint32_t sub = idx & ((1u << LATENCY_SUB_BITS) - 1);
+  uint32_t width = 1u << (e - LATENCY_SUB_BITS);
+  uint32_t lower = ((1u << LATENCY_SUB_BITS) + sub) << (e - LATENCY_SUB_BITS);
+  return lower + width - 1;
+}
+
+void latency_input(latency_src_t src, uint32_t input_us) {
+  if (pending_count == LATENCY_PENDING_MAX) return;   // Drop rather than block the input path
+  latency_tag_t *t = &pending[pending_count++];
+  t->input_us = input_us;
+  t->frame = 0;
+  t->src = src;
+}
+
+uint32_t latency_frame_begin(void) {
+  frame_id++;
+  if (frame_id == 0) frame_id = 1;   // 0 marks unbound tags
+  for (uint8_t i = 0; i < pending_count; i++) {
+    if (pending[i].frame == 0) pending[i].frame = frame_id;
+  }
+  return frame_id;
+}
+
+uint32_t latency_current_frame(void) {
+  return frame_id;
+}
+
+void latency_frame_flushed(uint32_t frame, uint32_t now_us) {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < pending_count; i++) {
+    latency_tag_t *t = &pending[i];
+    if (t->frame == 0 || (int32_t)(frame - t->frame) < 0) {
+      pending[kept++] = *t;         // Not rendered yet, keep waiting
+      continue;
+    }
+
+    uint32_t lat = now_us - t->input_us;
+    histogram[bucket_of(lat)]++;
+    total++;
+    if (lat > worst) worst = lat;
+
+    latency_record_t *r = &records[record_head % LATENCY_RECORDS];
+    r->input_us = t->input_us;
+    r->latency_us = lat;
+    r->src = t->src;
+    record_head++;
+  }
+  pending_count = kept;
+}
+
+uint32_t latency_count(void) {
+  return total;
+}
+
+uint32_t latency_percentile(uint32_t pct) {
+  if (total == 0) return 0;
+  uint64_t rank = ((uint64_t)total * pct + 99) / 100;   // 1-based rank of the percentile sample
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += histogram[i];
+    if (seen >= rank) return bucket_upper(i) < worst ? bucket_upper(i) : worst;
+  }
+  return worst;
+}
+
+uint32_t latency_max(void) {
+  return worst;
+}
+
+uint32_t latency_recent(latency_record_t *out, uint32_t max) {
+  uint32_t n = record_head < LATENCY_RECORDS ? record_head : LATENCY_RECORDS;
+  if (n > max) n = max;
+  for (uint32_t i = 0; i < n; i++) {
+    out[i] = records[(record_head - n + i) % LATENCY_RECORDS];
+  }
+  return n;
+}
+
+void latency_reset(void) {
+  memset(histogram, 0, sizeof(histogram));
+  total = 0;
+  worst = 0;
+}
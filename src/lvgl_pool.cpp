@@ -0,0 +1,268 @@
+/*
+ * LVGL memory pool, see lvgl_pool.h
+ */
+
+#include <string.h>
+#include "lvgl_pool.h"
+#include "alloc_trace.h"
+
+#if defined(ESP_PLATFORM)
+#include <esp_heap_caps.h>
+#include <multi_heap.h>
+
+static multi_heap_handle_t pool;
+static uint8_t pool_in_psram;
+
+// Take the pool block on first use: lv_init() allocates before any setup code could run
+static bool pool_ready(void) {
+  if (pool) return true;
+  void *block = NULL;
+  if (LVGL_POOL_PSRAM) {
+    block = heap_caps_malloc(LVGL_POOL_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    pool_in_psram = block != NULL;
+  }
+  if (!block) block = heap_caps_malloc(LVGL_POOL_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!block) return false;
+  pool = multi_heap_register(block, LVGL_POOL_SIZE);
+  return pool != NULL;
+}
+
+static void *pool_alloc(size_t size) {
+  return pool_ready() ? multi_heap_malloc(pool, size) : NULL;
+}
+
+static void pool_free(void *p) {
+  if (p) multi_heap_free(pool, p);
+}
+
+static void *pool_realloc(void *p, size_t size) {
+  return pool_ready() ? multi_heap_realloc(pool, p, size) : NULL;
+}
+
+void lvgl_pool_monitor(lvgl_pool_mon_t *mon) {
+  memset(mon, 0, sizeof(*mon));
+  if (!pool_ready()) return;
+  multi_heap_info_t info;
+  multi_heap_get_info(pool, &info);
+  mon->total = LVGL_POOL_SIZE;
+  mon->used = info.total_allocated_bytes;
+  mon->free = info.total_free_bytes;
+  mon->biggest_free = info.largest_free_block;
+  mon->min_free = info.minimum_free_bytes;
+  mon->blocks = info.allocated_blocks;
+  mon->frag_pct = mon->free ? 100 - (uint8_t)(100ull * mon->biggest_free / mon->free) : 0;
+  mon->in_psram = pool_in_psram;
+}
+#else
+// Host pool: a static region tiled by blocks, each with a boundary tag in front, allocated first
+// fit and merged with free neighbours when freed. Simpler than multi_heap's TLSF, but it fragments
+// under churn the same way, so the largest free block is measured rather than assumed.
+typedef struct {
+  uint32_t size;            // Block bytes, tag included; bit 0 set while allocated
+  uint32_t prev_size;       // Bytes of the block in front, 0 for the first
+} pool_tag_t;
+
+#define TAG_BYTES ((uint32_t)sizeof(pool_tag_t))   // Keeps payloads 8-byte aligned
+#define POOL_END (LVGL_POOL_SIZE & ~7u)            // Bytes the blocks tile
+
+static uint8_t region[LVGL_POOL_SIZE] __attribute__((aligned(8)));
+static uint32_t used, blocks, min_free = LVGL_POOL_SIZE;
+
+static pool_tag_t *tag_at(uint32_t offset) {
+  return (pool_tag_t *)(region + offset);
+}
+
+static uint32_t block_bytes(const pool_tag_t *t) {
+  return t->size & ~1u;
+}
+
+static bool block_used(const pool_tag_t *t) {
+  return t->size & 1u;
+}
+
+// The region starts as one free block
+static void pool_ready(void) {
+  if (tag_at(0)->size == 0) tag_at(0)->size = POOL_END;
+}
+
+static void *pool_alloc(size_t size) {
+  pool_ready();
+  if (size > POOL_END) return NULL;
+  uint32_t need = (TAG_BYTES + (uint32_t)size + 7u) & ~7u;
+  for (uint32_t off = 0; off < POOL_END; off += block_bytes(tag_at(off))) {
+    pool_tag_t *t = tag_at(off);
+    uint32_t bytes = block_bytes(t);
+    if (block_used(t) || bytes < need) continue;
+    if (bytes - need >= 2 * TAG_BYTES) {            // Split off the rest as a free block
+      pool_tag_t *rest = tag_at(off + need);
+      rest->size = bytes - need;
+      rest->prev_size = need;
+      if (off + bytes < POOL_END) tag_at(off + bytes)->prev_size = bytes - need;
+      bytes = need;
+    }
+    t->size = bytes | 1u;
+    used += bytes;
+    blocks++;
+    if (LVGL_POOL_SIZE - used < min_free) min_free = LVGL_POOL_SIZE - used;
+    return t + 1;
+  }
+  return NULL;                                       // Out of memory, or too fragmented
+}
+
+static void pool_free(void *p) {
+  if (!p) return;
+  pool_tag_t *t = (pool_tag_t *)p - 1;
+  uint32_t off = (uint32_t)((uint8_t *)t - region);
+  uint32_t bytes = block_bytes(t);
+  used -= bytes;
+  blocks--;
+
+  if (off + bytes < POOL_END && !block_used(tag_at(off + bytes))) bytes += block_bytes(tag_at(off + bytes));
+  if (off > 0 && !block_used(tag_at(off - t->prev_size))) {
+    off -= t->prev_size;
+    bytes += block_bytes(tag_at(off));
+  }
+  tag_at(off)->size = bytes;
+  if (off + bytes < POOL_END) tag_at(off + bytes)->prev_size = bytes;
+}
+
+static void *pool_realloc(void *p, size_t size) {
+  if (!p) return pool_alloc(size);
+  uint32_t have = block_bytes((pool_tag_t *)p - 1) - TAG_BYTES;
+  if (size <= have) return p;                        // Still fits its block
+  void *n = pool_alloc(size);
+  if (!n) return NULL;
+  memcpy(n, p, have);
+  pool_free(p);
+  return n;
+}
+
+void lvgl_pool_monitor(lvgl_pool_mon_t *mon) {
+  memset(mon, 0, sizeof(*mon));
+  pool_ready();
+  for (uint32_t off = 0; off < POOL_END; off += block_bytes(tag_at(off))) {
+    const pool_tag_t *t = tag_at(off);
+    if (!block_used(t) && block_bytes(t) - TAG_BYTES > mon->biggest_free) mon->biggest_free = block_bytes(t) - TAG_BYTES;
+  }
+  mon->total = LVGL_POOL_SIZE;
+  mon->used = used;
+  mon->free = LVGL_POOL_SIZE - used;
+  mon->min_free = min_free;
+  mon->blocks = blocks;
+  mon->frag_pct = mon->free ? 100 - (uint8_t)(100ull * mon->biggest_free / mon->free) : 0;
+}
+#endif
+
+// Page arena: one block of the pool handed out by bumping a pointer. Each
+// allocation carries its size in front so realloc can copy it.
+#define ARENA_ALIGN 8u
+
+static uint8_t *arena;              // Arena block (taken from the pool on first use)
+static uint32_t arena_top;          // Bump offset
+static bool arena_armed;
+static lvgl_arena_stats_t arena_stats;
+
+static bool in_arena(const void *p) {
+  return arena && (const uint8_t *)p >= arena && (const uint8_t *)p < arena + LVGL_ARENA_SIZE;
+}
+
+static uint32_t arena_size_of(const void *p) {
+  return *(const uint32_t *)((const uint8_t *)p - ARENA_ALIGN);
+}
+
+// Bump allocation; NULL when the arena is full
+static void *arena_alloc(size_t size) {
+  uint32_t need = (ARENA_ALIGN + size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  if (arena_top + need > LVGL_ARENA_SIZE) {
+    arena_stats.overflows++;
+    return NULL;
+  }
+  uint8_t *p = arena + arena_top + ARENA_ALIGN;
+  *(uint32_t *)(p - ARENA_ALIGN) = size;
+  arena_top += need;
+  arena_stats.allocs++;
+  arena_stats.live++;
+  if (arena_top > arena_stats.peak) arena_stats.peak = arena_top;
+  return p;
+}
+
+// A block of the arena was freed: the whole arena is reset once nothing in it is live
+static void arena_release(void) {
+  arena_stats.frees++;
+  if (--arena_stats.live == 0 && !arena_armed) {
+    arena_top = 0;
+    arena_stats.resets++;
+  }
+}
+
+void *lvgl_pool_alloc_at(size_t size, const void *site) {
+  if (arena_armed) {
+    void *p = arena_alloc(size);
+    if (p) {
+      alloc_trace_note(ALLOC_ARENA, size, site);
+      return p;
+    }
+  }
+  alloc_trace_note(ALLOC_POOL, size, site);
+  return pool_alloc(size);
+}
+
+void *lvgl_pool_alloc(size_t size) {
+  return lvgl_pool_alloc_at(size, __builtin_return_address(0));
+}
+
+void lvgl_pool_free(void *p) {
+  if (in_arena(p)) {
+    arena_release();
+    return;
+  }
+  pool_free(p);
+}
+
+void *lvgl_pool_realloc_at(void *p, size_t size, const void *site) {
+  if (!in_arena(p)) {                                // Pool blocks stay in the pool
+    alloc_trace_note(ALLOC_POOL, size, site);
+    return pool_realloc(p, size);
+  }
+
+  // Grow in place when it is the last block of the arena
+  uint32_t old = arena_size_of(p);
+  uint8_t *end = (uint8_t *)p + ((old + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1));
+  uint32_t grown = ((uint8_t *)p - arena) + ((size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1));
+  if (arena_armed && end == arena + arena_top && grown <= LVGL_ARENA_SIZE) {
+    alloc_trace_note(ALLOC_ARENA, size, site);
+    *(uint32_t *)((uint8_t *)p - ARENA_ALIGN) = size;
+    arena_top = grown;
+    if (arena_top > arena_stats.peak) arena_stats.peak = arena_top;
+    return p;
+  }
+
+  void *n = lvgl_pool_alloc_at(size, site);
+  if (!n) return NULL;
+  memcpy(n, p, old < size ? old : size);
+  arena_release();
+  return n;
+}
+
+void *lvgl_pool_realloc(void *p, size_t size) {
+  return lvgl_pool_realloc_at(p, size, __builtin_return_address(0));
+}
+
+bool lvgl_arena_begin(void) {
+  if (!arena) arena = (uint8_t *)pool_alloc(LVGL_ARENA_SIZE);
+  if (!arena || arena_stats.live != 0) return false;   // Still holding the previous page
+  arena_top = 0;
+  arena_armed = true;
+  return true;
+}
+
+void lvgl_arena_end(void) {
+  arena_armed = false;
+  if (arena_stats.live == 0) arena_top = 0;
+}
+
+void lvgl_arena_get_stats(lvgl_arena_stats_t *out) {
+  *out = arena_stats;
+  out->size = LVGL_ARENA_SIZE;
+  out->used = arena_top;
+}
@@ -24,6 +24,25 @@
 #include <SPI.h>
 #include <lvgl.h>
 #include <TFT_eSPI.h>
+#include "touch_filter.h"
+#include "spi_bus.h"
+#include "encoder.h"
+#include "latency.h"
+#include "draw_hooks.h"
+#include "label_cache.h"
+#include "shadow_fb.h"
+#include "scroll_anim.h"
+#include "refresh_ctl.h"
+#include "rle_img.h"
+#include "band_split.h"
+#include "render_kernels.h"
+#include "lvgl_pool.h"
+#include "alloc_trace.h"
+#include "menu_rows.h"
+#include "menu_nav.h"
+#include "prof.h"
+#include "perf_overlay.h"
+#include "boot_bench.h"
 
 // Pin definitions
 #define TOUCH_CS 21           // Pin for touch screen chip select
@@ -32,19 +51,31 @@
 #define BUZZER_PIN 13         // Pin for buzzer (not used in this code)
 #define CALIBRATION_FILE "/TouchCalData3" // File to store touch screen calibration data
 #define REPEAT_CAL true       // Force calibration on every start if set to true
-#define LVGL_REFRESH_TIME 20u // Refresh rate for the LittlevGL GUI in milliseconds
+#define LVGL_REFRESH_TIME 10u // Loop period in milliseconds while the GUI is active (it sleeps when static)
+#define SHADOW_FB_ENABLE 1    // Keep a copy of the panel and flush only the pixels that changed (boards with PSRAM)
+#define TRANSPORT_RGB444 0    // Send pixels as RGB444, 12 bits per pixel (ST7789/ST7735 panels only)
+#define PAGE_ARENA_ENABLE 1   // Build each sublist in the page arena of the LVGL pool and release it in one reset
+#define LEAN_ROWS 1           // Rows point at their flash text and share a const selected style instead of copying
+#define LABEL_CACHE_ROWS 1    // Lean rows show their text as an image from the label cache instead of a label
+#define PERF_OVERLAY 0        // Show FPS, CPU load, flush bandwidth, heap and latency in the top-right corner ('o' toggles)
+#define ALLOC_TRACE_ARM ALLOC_TRACE_LOG // Allocations after setup(): ALLOC_TRACE_OFF (count), _LOG (record) or _TRAP (abort)
+#define NAV_REPLAY_ROUNDS 0u  // Scripted passes through every menu page at the end of setup, then the allocation report (0 = off)
+#define STATS_REPORT_TIME 0u  // Interval for printing performance statistics over Serial in milliseconds (0 = off)
 #define outputA 25            // Pin A for rotary encoder
 #define outputB 33            // Pin B for rotary encoder
+#define ENCODER_REPLAY_STEPS 0 // Synthetic encoder steps injected per frame for the fast-spin replay (0 = off)
 
 // Variables for rotary encoder
 int counter = 0;              // Tracks current position in the list
-int aState;                   // Current state of encoder pin A
-int aLastState;               // Previous state of encoder pin A
 int list_size = 5;            // Total number of items in the main list
 int sublist_size = 4;         // Total number of items in the sublist (including "Return")
 int sublist_counter = 0;      // Tracks the current position in the sublist
 bool showing_sublist = false; // Flag to indicate if a sublist is being shown
+bool list_highlighted = false;    // Flag to indicate the selected style is shown in the main list
+bool sublist_highlighted = false; // Flag to indicate the selected style is shown in the sublist
 unsigned long lastPressTime = 0;          // Time of the last button press
+uint32_t buttonPressUs = 0;               // Time the current button press was detected (latency tag)
+bool buttonEventActive = false;           // Flag to indicate a click event is being sent for the button
 const unsigned long debounceDelay = 300;  // Debounce delay for the button in milliseconds
 
 // TFT display and lvgl setup
@@ -54,24 +85,66 @@ static const uint32_t screenHeight = 240;    // Height of the screen
 static lv_disp_draw_buf_t draw_buf;          // Buffer for drawing on the screen
 static lv_color_t buf[screenWidth * 10];     // Buffer size for display
 static lv_style_t style_default, style_selected; // GUI styles for default and selected items
+static lv_style_t *selected_style = &style_selected; // Style of the highlighted row (the const one with LEAN_ROWS)
+static bool lean_rows = LEAN_ROWS;           // Create rows with static text
+static refresh_ctl_t refresh;                // Chooses the loop period from the UI activity
+static scroll_anim_t scroll_anim;           // Eased scroll of the list holding the cursor
+static lv_obj_t *scroll_list;                // List the scroll animation applies to (NULL = none)
+static touch_filter_t touch_filter;          // Jitter/outlier filter for touch samples
+static bool touch_pressed;                   // Latest filtered touch state, refreshed by the SPI bus scheduler
+static int16_t touch_x, touch_y;             // Latest filtered touch point
+static bool page_arena = PAGE_ARENA_ENABLE;  // Build sublists in the page arena
+unsigned long lastReportTime = 0;           // Time of the last statistics report
+uint32_t disp_frames = 0;                   // Frames completely flushed since the last report
+uint32_t disp_pixels = 0;                   // Pixels flushed since the last report
+uint32_t disp_solid_pixels = 0;             // Pixels flushed as a panel-side solid fill
 lv_obj_t *label;                            // Pointer for the label widget
 lv_obj_t *list;                             // Pointer for the main list widget
 lv_obj_t *list_items[5];                    // Array to store list items (5 in total)
 lv_obj_t *sublist;                          // Pointer for the sublist widget
 lv_obj_t *sublist_items[4];                 // Array to store sublist items (4 in total)
 
+// Menu icons, RLE encoded by tools/rle_icons.py and drawn through the rle_img decoder
+#ifdef MENU_ICONS
+LV_IMG_DECLARE(icon_item);
+LV_IMG_DECLARE(icon_back);
+LV_IMG_DECLARE(icon_subitem);
+#define ICON_ITEM &icon_item
+#define ICON_BACK &icon_back
+#define ICON_SUBITEM &icon_subitem
+#else
+#define ICON_ITEM NULL
+#define ICON_BACK NULL
+#define ICON_SUBITEM NULL
+#endif
+
 // Function declarations
 void touch_calibrate();                     // Function to calibrate the touch screen
+void touch_sample();                        // Function to sample and filter the touch screen (SPI bus job)
 void lvgl_port_tp_read(lv_indev_drv_t *indev, lv_indev_data_t *data); // Function to read touch screen input
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p); // Function to update display with lvgl buffer
 static void list_event_handler(lv_event_t *e); // Function to handle events in the main list
 static void sublist_event_handler(lv_event_t *e); // Function to handle events in the sublist
 void lv_example_list(void);                 // Function to create the main list
+lv_obj_t *add_row(lv_obj_t *parent, const void *icon, const char *text); // Function to add a row to a list
 void lv_create_sublist(int parent_item);    // Function to create the sublist based on the selected parent item
 void lv_remove_sublist();                   // Function to remove the sublist from the screen
 void handle_encoder_list();                 // Function to handle rotary encoder navigation for the main list
 void handle_encoder_sublist();              // Function to handle rotary encoder navigation for the sublist
+void animate_scroll();                      // Function to apply the next step of the scroll animation
+bool ui_busy();                             // Function to check whether the GUI will redraw without new input
 void handle_button_press();                 // Function to handle the button press for selecting items
+void tag_button_latency();                  // Function to tag a UI change caused by the button for latency measurement
+void band_split_setup();                    // Function to start the second render worker and measure its break-even area
+void pool_report();                         // Function to print the LVGL pool telemetry
+void warm_up();                             // Function to render the first frames and one sub page before tracing starts
+void nav_replay();                          // Function to replay a standard navigation through every menu page
+void alloc_report();                        // Function to print allocation counts per subsystem
+void overlay_sample(perf_overlay_values_t *v); // Function to sample the values of the performance overlay
+void prof_dump();                           // Function to stream the profiler ring over Serial
+void prof_serial_write(const char *text, void *ctx); // Function to hand profiler output to Serial
+void report_stats();                        // Function to print performance statistics over Serial
+void handle_serial_command();               // Function to handle single-character commands received over Serial
 
 // Calibrate the touch screen and store calibration data in SPIFFS
 void touch_calibrate() {
@@ -119,50 +192,122 @@ void touch_calibrate() {
   }
 }
 
+// Function to sample the touch screen and update the filtered touch state (runs as an SPI bus job)
+void touch_sample() {
+  uint16_t touchX = 0, touchY = 0;    // Variables to hold touch coordinates
+  uint16_t touchZ = tft.getTouchRawZ(); // Raw pressure, thresholded by the filter
+  bool touched = touchZ > 0;          // Any contact; the filter drops (and counts) the light ones
+
+  if (touchZ >= touch_filter.cfg.z_threshold) {
+    tft.getTouchRaw(&touchX, &touchY);  // Read the raw position
+    tft.convertRawXY(&touchX, &touchY); // Apply the calibration
+    touched = touchX < screenWidth && touchY < screenHeight;
+  }
+
+  touch_pressed = touch_filter_update(&touch_filter, touched, touchX, touchY, touchZ, &touch_x, &touch_y);
+}
+
 // Function to read the touch screen input for lvgl
 void lvgl_port_tp_read(lv_indev_drv_t *indev, lv_indev_data_t *data) {
-  uint16_t touchX, touchY;       // Variables to hold touch coordinates
-  bool touched = tft.getTouch(&touchX, &touchY); // Check if the screen is touched
+  spi_bus_touch_service(false);       // Sample now unless a flush already took a fresh sample
 
-  if (!touched) {
-    data->state = LV_INDEV_STATE_REL; // If not touched, set input state to released
-  } else {
+  if (touch_pressed) {
     data->state = LV_INDEV_STATE_PR;  // If touched, set input state to pressed
-    data->point.x = touchX;           // Set X coordinate
-    data->point.y = touchY;           // Set Y coordinate
+    data->point.x = touch_x;          // Set filtered X coordinate
+    data->point.y = touch_y;          // Set filtered Y coordinate
+    refresh_ctl_activity(&refresh, millis()); // Keep the active refresh rate while touched
+  } else {
+    data->state = LV_INDEV_STATE_REL; // If not touched, set input state to released
   }
 }
 
+// Send callback of the shadow framebuffer: push one changed span
+static void shadow_send(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, void *ctx) {
+  spi_bus_push_pixels(x, y, w, h, (uint16_t *)pixels, !LV_COLOR_16_SWAP);
+}
+
+// Clock for the shadow framebuffer statistics and the allocation trace
+static uint32_t micros_clock() {
+  return micros();
+}
+
+// Trap callback of the allocation trace: name the allocation before the abort
+static void alloc_fail(const alloc_record_t *rec) {
+  Serial.printf("alloc after boot: %s %lu B at %p\n", alloc_trace_sub_name((alloc_sub_t)rec->sub),
+                (unsigned long)rec->size, rec->site);
+  Serial.flush();
+}
+
 // Function to flush the lvgl display buffer to the TFT screen
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  PROF_SCOPE(PROF_FLUSH);
   uint32_t w = (area->x2 - area->x1 + 1);  // Width of the area to be flushed
   uint32_t h = (area->y2 - area->y1 + 1);  // Height of the area to be flushed
 
-  tft.startWrite();        // Start writing to the TFT
-  tft.setAddrWindow(area->x1, area->y1, w, h);  // Set the area to be updated
-  tft.pushColors((uint16_t *)&color_p->full, w * h, true); // Push the colors to the screen
-  tft.endWrite();          // End writing
+  lv_color_t solid;
+  bool solid_flush = draw_hooks_take_solid(color_p, &solid);
+  bool bypass = BOOT_BENCH && boot_bench_bypass(); // Benchmark of unchanged frames: every pixel goes over the wire
+  if (solid_flush) {
+    // Nothing but one colour was drawn: fill on the panel side without reading the buffer
+    uint16_t c = solid.full;
+#if LV_COLOR_16_SWAP
+    c = (c >> 8) | (c << 8);   // pushBlock takes the colour in CPU order
+#endif
+    // The shadow copy holds buffer order; skip the fill if the panel already shows the colour.
+    // A bypass sends it anyway but still updates the copy, so the diff is right once it ends.
+    bool changed = !shadow_fb_active() || shadow_fb_fill(area->x1, area->y1, w, h, solid.full);
+    if (changed || bypass) {
+      spi_bus_fill(area->x1, area->y1, w, h, c);
+    }
+    disp_solid_pixels += w * h;
+  } else if (shadow_fb_active() && !bypass) {
+    // Compare with what is on the panel and send only the changed spans
+    shadow_fb_update(area->x1, area->y1, w, h, (const uint16_t *)&color_p->full, shadow_send, NULL);
+  } else {
+    shadow_fb_store(area->x1, area->y1, w, h, (const uint16_t *)&color_p->full); // Keep the copy in step during a bypass
+    // Push the colors to the screen in chunks, sampling touch in between.
+    // With LV_COLOR_16_SWAP the buffer is already in panel byte order and goes out untouched.
+    spi_bus_push_pixels(area->x1, area->y1, w, h, (uint16_t *)&color_p->full, !LV_COLOR_16_SWAP);
+  }
+  disp_pixels += w * h;
+
+  if (lv_disp_flush_is_last(disp)) {
+    disp_frames++;
+    latency_frame_flushed(latency_current_frame(), micros()); // The frame is now on the glass
+  }
+
+  if (BOOT_BENCH) {
+    boot_bench_flushed(solid_flush ? &solid.full : (const uint16_t *)&color_p->full, w * h, solid_flush);
+  }
 
   lv_disp_flush_ready(disp); // Tell lvgl that flushing is done
 }
 
-// Event handler for when a main list item is clicked
-static void list_event_handler(lv_event_t *e) {
+// Function to find the row of a list a bubbled click came from; -1 for a click on the list itself
+static int32_t clicked_row(lv_event_t *e) {
   lv_obj_t *obj = lv_event_get_target(e);  // Get the clicked list item object
-  uint32_t index = (uint32_t)lv_event_get_user_data(e); // Get the index of the clicked item
+  if (lv_obj_get_parent(obj) != lv_event_get_current_target(e)) return -1;
+  return lv_obj_get_index(obj);            // Rows are the list's children in order
+}
+
+// Event handler of the main list, called for clicks bubbling up from its items
+static void list_event_handler(lv_event_t *e) {
+  int32_t index = clicked_row(e);          // Index of the clicked item
+  if (index < 0) return;
 
   if (!showing_sublist) { // If sublist is not already showing
     lv_create_sublist(index); // Create sublist for the selected item
+    tag_button_latency();     // Measure until the sublist is displayed
   }
 }
 
-// Event handler for when a sublist item is clicked
+// Event handler of the sublist, called for clicks bubbling up from its items
 static void sublist_event_handler(lv_event_t *e) {
-  lv_obj_t *obj = lv_event_get_target(e);  // Get the clicked sublist item object
-  uint32_t index = (uint32_t)lv_event_get_user_data(e); // Get the index of the clicked sublist item
+  int32_t index = clicked_row(e);          // Index of the clicked sublist item
 
   if (index == 0) {         // If "Return" is selected
     lv_remove_sublist();     // Remove the sublist from the screen
+    tag_button_latency();    // Measure until the main list is displayed again
   }
 }
 
@@ -170,129 +315,159 @@ static void sublist_event_handler(lv_event_t *e) {
 void lv_example_list(void) {
   list = lv_list_create(lv_scr_act());     // Create a list object on the active screen
 
+  lv_obj_add_event_cb(list, list_event_handler, LV_EVENT_CLICKED, NULL); // One callback for the clicks of all items
+
   // Create 5 items in the list and add them to the screen
   for (int i = 0; i < list_size; i++) {
-    list_items[i] = lv_list_add_btn(list, NULL, "Item"); // Add each item to the list
-    lv_obj_add_event_cb(list_items[i], list_event_handler, LV_EVENT_CLICKED, (void *)i); // Add event callback for item click
+    list_items[i] = add_row(list, ICON_ITEM, "Item"); // Add each item to the list
   }
 
   lv_obj_align(list, LV_ALIGN_CENTER, 0, 0);  // Center the list on the screen
 }
 
+// Function to add a row to a list; lean rows keep a pointer to the text, which must be a literal,
+// and with LABEL_CACHE_ROWS show it as a label cache image. Clicks bubble up to the list, whose single
+// callback finds the row by its index.
+lv_obj_t *add_row(lv_obj_t *parent, const void *icon, const char *text) {
+  lv_obj_t *row = !lean_rows ? lv_list_add_btn(parent, icon, text)
+                : LABEL_CACHE_ROWS ? menu_rows_add_cached(parent, icon, text) : menu_rows_add(parent, icon, text);
+  lv_obj_add_flag(row, LV_OBJ_FLAG_EVENT_BUBBLE);
+  return row;
+}
+
 // Function to create a sublist based on the selected parent item
 void lv_create_sublist(int parent_item) {
   showing_sublist = true;      // Set flag to show sublist
+  sublist_highlighted = false; // New sublist items carry no selected style yet
+
+  // The page's objects, labels and event descriptors come from the arena; it is reset
+  // in one step once lv_remove_sublist() has freed them all
+  bool in_arena = page_arena && lvgl_arena_begin();
 
   sublist = lv_list_create(lv_scr_act());    // Create a sublist object on the active screen
 
   // Create 4 sublist items (1st item is "Return" to go back to main list)
-  sublist_items[0] = lv_list_add_btn(sublist, NULL, "Return");   // Add "Return" button to the sublist
-  lv_obj_add_event_cb(sublist_items[0], sublist_event_handler, LV_EVENT_CLICKED, (void *)0); // Add event callback for "Return"
+  lv_obj_add_event_cb(sublist, sublist_event_handler, LV_EVENT_CLICKED, NULL); // One callback for the clicks of all items
+
+  sublist_items[0] = add_row(sublist, ICON_BACK, "Return");   // Add "Return" button to the sublist
   
   for (int i = 1; i < sublist_size; i++) {
-    sublist_items[i] = lv_list_add_btn(sublist, NULL, "SubItem"); // Add subitems to the sublist
-    lv_obj_add_event_cb(sublist_items[i], sublist_event_handler, LV_EVENT_CLICKED, (void *)i); // Add event callback for subitem click
+    sublist_items[i] = add_row(sublist, ICON_SUBITEM, "SubItem"); // Add subitems to the sublist
   }
 
   lv_obj_align(sublist, LV_ALIGN_CENTER, 0, 0); // Center the sublist on the screen
+
+  if (in_arena) {
+    lvgl_arena_end();          // Later allocations (rendering, scrolling) go to the pool again
+  }
 }
 
 // Function to remove the sublist and return to the main list
 void lv_remove_sublist() {
+  if (scroll_list == sublist) scroll_list = NULL; // Stop animating the deleted list
   lv_obj_del(sublist);      // Delete the sublist object from the screen
   showing_sublist = false;  // Reset flag to indicate sublist is no longer showing
 }
 
-// Function to handle the rotary encoder navigation for the main list
-void handle_encoder_list() {
-  aState = digitalRead(outputA);   // Read the state of encoder pin A
-
-  // If the state has changed (indicating rotation)
-  if (aState != aLastState) {
-    if (digitalRead(outputB) != aState) {  // If pin B state differs from A
-      counter++;       // Clockwise rotation (increment counter)
-    } else {
-      counter--;       // Counterclockwise rotation (decrement counter)
-    }
+// Function to apply the next scroll offset. my_disp_flush() is synchronous, so no flush is ever
+// in flight here; a late frame just makes the animator jump further along its curve.
+void animate_scroll() {
+  ALLOC_SCOPE(ALLOC_SUB_INPUT);
+  PROF_SCOPE(PROF_SCROLL);
+  if (scroll_list == NULL) return;
+  int32_t y;
+  if (scroll_anim_step(&scroll_anim, millis(), &y)) {
+    lv_obj_scroll_to_y(scroll_list, y, LV_ANIM_OFF); // The animator does the easing, not LVGL
+  }
+}
 
-    // Ensure the counter stays within valid bounds (0 to list_size-1)
-    if (counter >= list_size) counter = 0;
-    if (counter < 0) counter = list_size - 1;
+// Function to check for redraws that need frames without new input: animations and invalidated areas
+bool ui_busy() {
+  return scroll_anim.active || lv_anim_count_running() > 0 || lv_disp_get_default()->inv_p > 0;
+}
 
-    // Update the selected item style
-    for (int i = 0; i < list_size; i++) {
-      if (i == counter) {
-        lv_obj_add_style(list_items[i], &style_selected, 0); // Apply selected style to the current item
-      } else {
-        lv_obj_remove_style(list_items[i], &style_selected, 0); // Remove selected style from other items
-      }
-    }
+// Function to handle the rotary encoder navigation for the main list
+void handle_encoder_list() {
+  ALLOC_SCOPE(ALLOC_SUB_INPUT);
+  PROF_SCOPE(PROF_ENCODER);
+  uint32_t first_us;
+  int32_t delta = encoder_take_delta(&first_us);  // Net steps since the last frame
+  if (delta != 0) refresh_ctl_activity(&refresh, millis());
+  if (delta != 0 && menu_nav_move(list_items, list_size, &counter, &list_highlighted, delta, selected_style)) {
+    latency_input(LATENCY_SRC_ENCODER, first_us);  // Measure from the first edge of the batch
+    menu_nav_follow(&scroll_anim, &scroll_list, list, list_items[counter], millis()); // Bring the new row into view
   }
-  aLastState = aState;     // Save the last state of encoder pin A
 }
 
 // Function to handle the rotary encoder navigation for the sublist
 void handle_encoder_sublist() {
-  aState = digitalRead(outputA);   // Read the state of encoder pin A
-
-  // If the state has changed (indicating rotation)
-  if (aState != aLastState) {
-    if (digitalRead(outputB) != aState) {  // If pin B state differs from A
-      sublist_counter++;    // Clockwise rotation (increment sublist counter)
-    } else {
-      sublist_counter--;    // Counterclockwise rotation (decrement sublist counter)
-    }
-
-    // Ensure the sublist counter stays within valid bounds (0 to sublist_size-1)
-    if (sublist_counter >= sublist_size) sublist_counter = 0;
-    if (sublist_counter < 0) sublist_counter = sublist_size - 1;
-
-    // Update the selected sublist item style
-    for (int i = 0; i < sublist_size; i++) {
-      if (i == sublist_counter) {
-        lv_obj_add_style(sublist_items[i], &style_selected, 0); // Apply selected style to current sublist item
-      } else {
-        lv_obj_remove_style(sublist_items[i], &style_selected, 0); // Remove selected style from other sublist items
-      }
-    }
+  ALLOC_SCOPE(ALLOC_SUB_INPUT);
+  PROF_SCOPE(PROF_ENCODER);
+  uint32_t first_us;
+  int32_t delta = encoder_take_delta(&first_us);  // Net steps since the last frame
+  if (delta != 0) refresh_ctl_activity(&refresh, millis());
+  if (delta != 0 && menu_nav_move(sublist_items, sublist_size, &sublist_counter, &sublist_highlighted, delta,
+                                   selected_style)) {
+    latency_input(LATENCY_SRC_ENCODER, first_us);  // Measure from the first edge of the batch
+    menu_nav_follow(&scroll_anim, &scroll_list, sublist, sublist_items[sublist_counter], millis()); // Bring the new row into view
   }
-  aLastState = aState;     // Save the last state of encoder pin A
 }
 
 // Function to handle the button press to select highlighted items
 void handle_button_press() {
+  ALLOC_SCOPE(ALLOC_SUB_INPUT);
+  PROF_SCOPE(PROF_BUTTON);
   if (digitalRead(BUTTON_PIN_2) == LOW) {   // If button is pressed
     unsigned long current_time = millis();  // Get the current time
+    uint32_t press_us = micros();           // Time the press was seen, for latency measurement
 
     // Check for debounce (button press should only trigger after debounceDelay)
     if (current_time - lastPressTime > debounceDelay) {
       lastPressTime = current_time;  // Update last press time
+      buttonPressUs = press_us;
+      refresh_ctl_activity(&refresh, current_time);
+      buttonEventActive = true;      // Handlers tag their UI change with the press time
 
       if (showing_sublist) {
         lv_event_send(sublist_items[sublist_counter], LV_EVENT_CLICKED, NULL); // Trigger click event for selected sublist item
       } else {
         lv_event_send(list_items[counter], LV_EVENT_CLICKED, NULL); // Trigger click event for selected main list item
       }
+      buttonEventActive = false;
     }
   }
 }
 
+// Function to tag a UI change caused by the button (touch clicks are not tagged)
+void tag_button_latency() {
+  if (buttonEventActive) {
+    latency_input(LATENCY_SRC_BUTTON, buttonPressUs);
+  }
+}
+
 // Main setup function (runs once)
 void setup() {
   Serial.begin(115200);     // Initialize serial communication for debugging
+  alloc_trace_init(micros_clock, alloc_fail); // Allocations are counted from here, recorded once armed
+  prof_init(ESP.getCpuFreqMHz());           // Probe durations are CPU cycles
 
   // Set pin modes for the rotary encoder and button
-  pinMode(outputA, INPUT_PULLUP);       // Set pin A as input
-  pinMode(outputB, INPUT_PULLUP);       // Set pin B as input
+  encoder_begin(outputA, outputB);      // Encoder pins, decoded by interrupt
   pinMode(BUTTON_PIN_2, INPUT_PULLUP); // Set button pin as input with pull-up resistor
-
-  aLastState = digitalRead(outputA);  // Initialize the last state of encoder pin A
+  encoder_wake_on_pin(BUTTON_PIN_2);   // A press also ends the idle sleep
 
   tft.begin();              // Initialize the TFT display
   tft.setRotation(1);       // Set the display rotation (landscape)
   touch_calibrate();        // Calibrate the touch screen
+  if (SHADOW_FB_ENABLE) {
+    tft.fillScreen(TFT_BLACK);  // Known panel content to start the shadow copy from (black is 0 in either byte order)
+    if (!shadow_fb_init(screenWidth, screenHeight, 0, micros_clock)) {
+      Serial.println("shadow framebuffer: no PSRAM, flushing full areas");
+    }
+  }
 
   lv_init();                // Initialize LittlevGL (lvgl) for GUI management
+  rle_img_init();           // Decoder for the RLE menu icons
   lv_disp_draw_buf_init(&draw_buf, buf, NULL, screenWidth * 10);  // Initialize lvgl draw buffer
 
   // Initialize the lvgl display driver
@@ -302,9 +477,17 @@ void setup() {
   disp_drv.ver_res = screenHeight;    // Set vertical resolution
   disp_drv.flush_cb = my_disp_flush;  // Set flush callback to update the display
   disp_drv.draw_buf = &draw_buf;      // Set draw buffer
+  disp_drv.draw_ctx_init = draw_hooks_ctx_init; // Software renderer with the RGB565 fill/copy/blend kernels
   lv_disp_drv_register(&disp_drv);    // Register the display driver with lvgl
+  band_split_setup();                 // Large blends are shared with the other core
 
   // Initialize the lvgl touch input driver
+  touch_filter_init(&touch_filter, NULL);   // Filter with the TOUCH_FILTER_* defaults
+  spi_bus_init(&tft);                       // Share the SPI bus between display and touch
+  spi_bus_set_touch_job(touch_sample, SPI_BUS_TOUCH_PERIOD_US); // Touch sampling runs between flush chunks
+  if (TRANSPORT_RGB444) {
+    spi_bus_set_format(SPI_BUS_RGB444);     // 12 bits per pixel on the wire
+  }
   static lv_indev_drv_t indev_drv;
   lv_indev_drv_init(&indev_drv);
   indev_drv.type = LV_INDEV_TYPE_POINTER;   // Set input type as pointer (touchscreen)
@@ -312,17 +495,362 @@ void setup() {
   lv_indev_drv_register(&indev_drv);        // Register the input driver with lvgl
 
   // Initialize lvgl styles for selected and default items
-  lv_style_init(&style_selected);
-  lv_style_set_bg_color(&style_selected, lv_color_hex(0xFF0000)); // Set selected style background color (red)
+  if (LEAN_ROWS) {
+    selected_style = (lv_style_t *)&menu_style_selected; // Same red, properties in flash
+  } else {
+    lv_style_init(&style_selected);
+    lv_style_set_bg_color(&style_selected, lv_color_hex(0xFF0000)); // Set selected style background color (red)
+  }
+
+  refresh_ctl_init(&refresh, LVGL_REFRESH_TIME, millis()); // Loop period follows the UI activity
+  scroll_anim_init(&scroll_anim, LVGL_REFRESH_TIME, 0); // List scrolls ease over SCROLL_ANIM_FRAMES frames
 
   // Create the main list on the screen
   lv_example_list();
+  perf_overlay_create(overlay_sample, PERF_OVERLAY); // Diagnostics layer above the menu (hidden unless enabled)
+
+  const boot_bench_ui_t bench_ui = {
+      (const uint16_t *)buf, screenWidth, screenHeight, sizeof(buf) / sizeof(buf[0]) / screenWidth, list_size,
+      lv_create_sublist, lv_remove_sublist, &page_arena, &lean_rows, add_row, ICON_ITEM, selected_style};
+  boot_bench_run(&bench_ui);  // Boot benchmarks of boot_bench.h (BOOT_BENCH)
+
+  lvgl_arena_begin();         // Reserve the page arena now rather than on the first sublist
+  lvgl_arena_end();
+  warm_up();                  // First frame and first sub page allocate what they keep
+  alloc_trace_arm(ALLOC_TRACE_ARM); // Boot is over: every further allocation is recorded (or trapped)
+  if (NAV_REPLAY_ROUNDS) {
+    nav_replay();             // Allocations made by a standard navigation, per subsystem
+  }
+}
+
+// Function to start the band worker on the other core and split only areas where it pays off
+void band_split_setup() {
+  if (!band_split_begin()) {
+    Serial.println("band split: no worker, rendering on one core");
+    return;
+  }
+  // The draw buffer holds nothing yet, use it as scratch for the measurement
+  uint32_t threshold = draw_hooks_calibrate_split((uint16_t *)buf, screenWidth, sizeof(buf) / sizeof(buf[0]) / screenWidth, 20);
+  band_split_set_threshold(threshold);
+  if (threshold == UINT32_MAX) {
+    Serial.println("band split: never faster, disabled");
+  } else {
+    Serial.printf("band split: break-even %lu px\n", (unsigned long)threshold);
+  }
+}
+
+// Function to print used, free and largest free block of the LVGL pool
+void pool_report() {
+  lvgl_pool_mon_t mon;
+  lvgl_pool_monitor(&mon);
+  Serial.printf("pool %s used=%lu free=%lu biggest=%lu frag=%u%% min_free=%lu blocks=%lu\n",
+                mon.in_psram ? "psram" : "internal", (unsigned long)mon.used, (unsigned long)mon.free,
+                (unsigned long)mon.biggest_free, (unsigned)mon.frag_pct, (unsigned long)mon.min_free,
+                (unsigned long)mon.blocks);
+  lvgl_arena_stats_t arena;
+  lvgl_arena_get_stats(&arena);
+  Serial.printf("page arena used=%lu/%lu peak=%lu live=%lu resets=%lu overflows=%lu\n",
+                (unsigned long)arena.used, (unsigned long)arena.size, (unsigned long)arena.peak,
+                (unsigned long)arena.live, (unsigned long)arena.resets, (unsigned long)arena.overflows);
+}
+
+// Function to run frames of the main loop, without sleeping, until the GUI is static again
+static void replay_settle() {
+  do {
+    {
+      ALLOC_SCOPE(ALLOC_SUB_LVGL);
+      lv_timer_handler();
+      lv_refr_now(NULL);
+    }
+    if (showing_sublist) {
+      handle_encoder_sublist();
+    } else {
+      handle_encoder_list();
+    }
+    animate_scroll();
+    delay(LVGL_REFRESH_TIME);
+  } while (ui_busy());
+}
+
+// Function to click the selected item the way the button does
+static void replay_click() {
+  ALLOC_SCOPE(ALLOC_SUB_INPUT);
+  if (showing_sublist) {
+    lv_event_send(sublist_items[sublist_counter], LV_EVENT_CLICKED, NULL);
+  } else {
+    lv_event_send(list_items[counter], LV_EVENT_CLICKED, NULL);
+  }
+}
+
+// Function to do once what the first frames of loop() would otherwise do after arming: the first
+// refresh takes LVGL's draw and layer buffers, and a sub page opened and closed once leaves behind
+// what every later page reuses. The screen ends as it started, on the main list.
+void warm_up() {
+  lv_timer_handler();
+  lv_refr_now(NULL);
+  lv_create_sublist(0);
+  lv_refr_now(NULL);
+  lv_remove_sublist();
+  lv_refr_now(NULL);
+}
+
+// Function to step through every main item, open its sublist, walk it and return, then report the allocations
+void nav_replay() {
+  uint32_t start = alloc_trace_since_arm();
+  alloc_trace_reset_stats();
+  for (uint32_t round = 0; round < NAV_REPLAY_ROUNDS; round++) {
+    for (int item = 0; item < list_size; item++) {
+      encoder_inject(1);              // Next main item
+      replay_settle();
+      replay_click();                 // Open its sublist
+      replay_settle();
+      for (int step = 0; step < sublist_size; step++) {
+        encoder_inject(1);            // Walk every subitem and wrap around to "Return"
+        replay_settle();
+      }
+      replay_click();                 // Back to the main list
+      replay_settle();
+    }
+  }
+  Serial.printf("nav replay %lu rounds: %lu heap/pool allocations after boot\n",
+                (unsigned long)NAV_REPLAY_ROUNDS, (unsigned long)(alloc_trace_since_arm() - start));
+  alloc_report();
+}
+
+// Function to print the allocations per subsystem since the last reset
+void alloc_report() {
+  for (int sub = 0; sub < ALLOC_SUB_COUNT; sub++) {
+    alloc_sub_stats_t s;
+    alloc_trace_get_stats((alloc_sub_t)sub, &s);
+    Serial.printf("alloc %-6s heap=%lu (%lu B) pool=%lu (%lu B) arena=%lu (%lu B)\n",
+                  alloc_trace_sub_name((alloc_sub_t)sub), (unsigned long)s.count[ALLOC_HEAP],
+                  (unsigned long)s.bytes[ALLOC_HEAP], (unsigned long)s.count[ALLOC_POOL],
+                  (unsigned long)s.bytes[ALLOC_POOL], (unsigned long)s.count[ALLOC_ARENA],
+                  (unsigned long)s.bytes[ALLOC_ARENA]);
+  }
+  Serial.printf("alloc since boot=%lu mode=%u\n", (unsigned long)alloc_trace_since_arm(),
+                (unsigned)alloc_trace_mode());
+}
+
+// Function to return how much a counter grew since the previous call; counters restart when report_stats() resets them
+static uint32_t counter_since(uint32_t now, uint32_t *prev) {
+  uint32_t d = now >= *prev ? now - *prev : now;
+  *prev = now;
+  return d;
+}
+
+// Function to sample the performance overlay: rates over the time since the previous sample
+void overlay_sample(perf_overlay_values_t *v) {
+  static uint32_t last_ms, last_bytes, last_busy, last_wall;
+  uint32_t now = millis();
+  uint32_t dt = now - last_ms ? now - last_ms : 1;
+  last_ms = now;
+
+  spi_bus_stats_t disp_stats;
+  spi_bus_get_stats(SPI_BUS_DISPLAY, &disp_stats);
+  uint32_t busy = 0, wall = 0;
+  for (int st = 0; st < REFRESH_STATES; st++) {
+    busy += refresh.stats[st].busy_us;
+    wall += refresh.stats[st].wall_us;
+  }
+  uint32_t bytes = counter_since(disp_stats.bytes, &last_bytes);
+  busy = counter_since(busy, &last_busy);
+  wall = counter_since(wall, &last_wall);
+
+  lvgl_pool_mon_t mon;
+  lvgl_pool_monitor(&mon);
+  v->fps_x10 = refresh_ctl_rate_mhz(&refresh) / 100;
+  v->cpu_pct = wall ? (uint32_t)(100ull * busy / wall) : 0;
+  v->flush_kbps = (uint32_t)((uint64_t)bytes * 1000 / dt / 1024);
+  v->heap_used = mon.used;
+  v->heap_pct = mon.total ? (uint32_t)(100ull * mon.used / mon.total) : 0;
+  v->latency_us = latency_percentile(95);
+}
+
+// Function to stream the profiler records, oldest first, in chunks; recording pauses meanwhile.
+// Lines: "prof X <name> <core> <start ticks> <duration ticks>" for a timed block and
+// "prof C <name> <core> <ticks> <value>" for a counter, between begin and end markers.
+void prof_dump() {
+  prof_record_t chunk[32];
+  prof_pause(true);
+  uint32_t held = prof_count();
+  Serial.printf("prof begin ticks_per_us=%lu records=%lu total=%lu\n", (unsigned long)prof_ticks_per_us(),
+                (unsigned long)held, (unsigned long)prof_total());
+  for (uint32_t from = 0, n; (n = prof_read(chunk, from, 32)) > 0; from += n) {
+    for (uint32_t i = 0; i < n; i++) {
+      prof_id_t id = (prof_id_t)chunk[i].id;
+      Serial.printf("prof %c %s %u %lu %lu\n", prof_is_counter(id) ? 'C' : 'X', prof_name(id), chunk[i].core,
+                    (unsigned long)chunk[i].start, (unsigned long)chunk[i].ticks);
+    }
+  }
+  Serial.println("prof end");
+  prof_pause(false);
+}
+
+// Function to hand profiler output to Serial
+void prof_serial_write(const char *text, void *ctx) {
+  Serial.print(text);
+}
+
+// Function to print performance statistics over Serial
+void report_stats() {
+  ALLOC_SCOPE(ALLOC_SUB_SERIAL);
+  spi_bus_stats_t disp_stats;
+  spi_bus_get_stats(SPI_BUS_DISPLAY, &disp_stats);
+  Serial.printf("flush frames=%lu us/frame=%lu\n", (unsigned long)disp_frames,
+                (unsigned long)(disp_frames ? disp_stats.busy_us / disp_frames : 0));
+  Serial.printf("flush solid fast path=%.1f%% of %lu px\n",
+                disp_pixels ? 100.0f * disp_solid_pixels / disp_pixels : 0.0f, (unsigned long)disp_pixels);
+  disp_frames = 0;
+  disp_pixels = 0;
+  disp_solid_pixels = 0;
+
+  spi_bus_report(Serial);   // SPI bus utilisation and waits per client
+  spi_bus_reset_stats();
+
+  draw_hooks_report(Serial); // Render kernel throughput
+  draw_hooks_reset_stats();
+
+  band_split_stats_t bands;   // Kernel calls shared with the other core
+  band_split_get_stats(&bands);
+  Serial.printf("band split=%lu single=%lu threshold=%lu px\n", (unsigned long)bands.split,
+                (unsigned long)bands.single, (unsigned long)band_split_threshold());
+  band_split_reset_stats();
+
+  pool_report();              // LVGL heap use and fragmentation
+
+  alloc_report();             // Allocations per subsystem
+  alloc_trace_reset_stats();
+
+  perf_overlay_stats_t overlay; // Overlay samples, how many changed the screen and the area they redrew
+  perf_overlay_get_stats(&overlay);
+  if (perf_overlay_shown()) {
+    Serial.printf("overlay updates=%lu redraws=%lu px=%lu\n", (unsigned long)overlay.updates,
+                  (unsigned long)overlay.redraws, (unsigned long)overlay.pixels);
+  }
+  perf_overlay_reset_stats();
+
+  label_cache_stats_t labels; // Label images reused, rendered and evicted
+  label_cache_get_stats(&labels);
+  Serial.printf("label cache hits=%lu misses=%lu evictions=%lu bypass=%lu images=%lu bytes=%lu/%lu peak=%lu\n",
+                (unsigned long)labels.hits, (unsigned long)labels.misses, (unsigned long)labels.evictions,
+                (unsigned long)labels.bypass, (unsigned long)labels.entries, (unsigned long)labels.bytes,
+                (unsigned long)LABEL_CACHE_BYTES, (unsigned long)labels.peak_bytes);
+  label_cache_reset_stats();
+
+  rle_img_stats_t icons;      // Icon lines decoded into LVGL's line buffer
+  rle_img_get_stats(&icons);
+  Serial.printf("icons lines=%lu px=%lu %.1f MPix/s\n", (unsigned long)icons.lines, (unsigned long)icons.pixels,
+                icons.cycles ? (float)icons.pixels * ESP.getCpuFreqMHz() / icons.cycles : 0.0f);
+  rle_img_reset_stats();
+
+  // SPI traffic saved by the shadow framebuffer against the CPU time spent diffing
+  if (shadow_fb_active()) {
+    shadow_fb_stats_t fb;
+    shadow_fb_get_stats(&fb);
+    Serial.printf("shadow fb in=%lu px sent=%lu px saved=%lu B spans=%lu diff=%lu us\n",
+                  (unsigned long)fb.pixels_in, (unsigned long)fb.pixels_sent,
+                  (unsigned long)(fb.pixels_in - fb.pixels_sent) * 2, (unsigned long)fb.spans,
+                  (unsigned long)fb.diff_us);
+    shadow_fb_reset_stats();
+  }
+
+  // Input-to-photon latency percentiles
+  Serial.printf("latency n=%lu p50=%luus p95=%luus p99=%luus max=%luus\n",
+                (unsigned long)latency_count(), (unsigned long)latency_percentile(50),
+                (unsigned long)latency_percentile(95), (unsigned long)latency_percentile(99),
+                (unsigned long)latency_max());
+  latency_reset();
+
+  // Selection restyles per frame in which the cursor moved
+  menu_nav_stats_t nav;
+  menu_nav_get_stats(&nav);
+  Serial.printf("nav steps=%lu frames=%lu styles/frame=%.2f max=%lu\n",
+                (unsigned long)encoder_total_steps(), (unsigned long)nav.frames,
+                nav.frames ? (float)nav.styles / nav.frames : 0.0f, (unsigned long)nav.max_styles);
+
+  // CPU utilisation and refresh rate per activity state
+  for (int i = 0; i < REFRESH_STATES; i++) {
+    const refresh_state_stats_t *rs = &refresh.stats[i];
+    Serial.printf("refresh %s loops=%lu frames=%lu cpu=%.1f%% fps=%.1f\n", refresh_ctl_state_name((refresh_state_t)i),
+                  (unsigned long)rs->loops, (unsigned long)rs->frames,
+                  rs->wall_us ? 100.0f * rs->busy_us / rs->wall_us : 0.0f,
+                  rs->wall_us ? 1e6f * rs->frames / rs->wall_us : 0.0f);
+  }
+  Serial.printf("refresh now=%s rate=%.1f Hz\n", refresh_ctl_state_name(refresh.state),
+                refresh_ctl_rate_mhz(&refresh) / 1000.0f);
+  refresh_ctl_reset_stats(&refresh);
+
+  // Scroll animation pacing
+  const scroll_anim_stats_t *sa = &scroll_anim.stats;
+  Serial.printf("scroll frames=%lu fps=%.1f dropped=%lu\n", (unsigned long)sa->frames,
+                sa->active_ms ? 1000.0f * sa->frames / sa->active_ms : 0.0f, (unsigned long)sa->dropped);
+  scroll_anim_reset_stats(&scroll_anim);
+}
+
+// Function to handle single-character commands received over Serial
+void handle_serial_command() {
+  ALLOC_SCOPE(ALLOC_SUB_SERIAL);
+  PROF_SCOPE(PROF_SERIAL);
+  while (Serial.available() > 0) {
+    switch (Serial.read()) {
+      case 's':               // Print the statistics report now
+        report_stats();
+        break;
+      case 'm':               // Print the LVGL pool telemetry now
+        pool_report();
+        break;
+      case 'o':               // Toggle the performance overlay
+        perf_overlay_show(!perf_overlay_shown());
+        break;
+      case 'p':               // Stream the profiler ring for offline analysis (tools/trace_to_chrome.py)
+        prof_dump();
+        break;
+      case 't':               // Stream the profiler ring as a Chrome trace
+        prof_write_chrome(prof_serial_write, NULL);
+        break;
+      case 'a': {             // Print the allocation counts and the allocations recorded since boot
+        alloc_report();
+        alloc_record_t records[ALLOC_TRACE_RECORDS];
+        uint32_t n = alloc_trace_recent(records, ALLOC_TRACE_RECORDS);
+        for (uint32_t i = 0; i < n; i++) {
+          Serial.printf("alloc t=%lu %s kind=%u size=%lu site=%p\n", (unsigned long)records[i].time_us,
+                        alloc_trace_sub_name((alloc_sub_t)records[i].sub), records[i].kind,
+                        (unsigned long)records[i].size, records[i].site);
+        }
+        break;
+      }
+      case 'l': {             // Dump the recent per-event latency records
+        latency_record_t records[LATENCY_RECORDS];
+        uint32_t n = latency_recent(records, LATENCY_RECORDS);
+        for (uint32_t i = 0; i < n; i++) {
+          Serial.printf("lat src=%u t=%lu us=%lu\n", records[i].src,
+                        (unsigned long)records[i].input_us, (unsigned long)records[i].latency_us);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
 }
 
 // Main loop function (runs repeatedly)
 void loop() {
-  lv_timer_handler();        // Handle lvgl tasks (GUI refresh)
-  delay(LVGL_REFRESH_TIME);  // Delay to control refresh rate
+  uint32_t loop_start = micros();
+  PROF_BEGIN(loop_ticks);
+  uint32_t frames_before = disp_frames;
+
+  latency_frame_begin();     // Inputs seen so far are displayed by this refresh
+  {
+    ALLOC_SCOPE(ALLOC_SUB_LVGL);
+    PROF_SCOPE(PROF_TIMER);
+    lv_timer_handler();      // Handle lvgl tasks (GUI refresh)
+  }
+
+  if (ENCODER_REPLAY_STEPS) {
+    encoder_inject(ENCODER_REPLAY_STEPS); // Fast-spin replay: several steps land in every frame
+  }
 
   if (showing_sublist) {     // If a sublist is being shown
     handle_encoder_sublist();  // Handle rotary encoder for sublist navigation
@@ -331,4 +859,28 @@ void loop() {
   }
 
   handle_button_press();     // Handle button press for item selection
+
+  animate_scroll();          // Step the list scroll after the inputs of this frame
+
+  handle_serial_command();   // Handle statistics and dump requests
+
+  if (STATS_REPORT_TIME && millis() - lastReportTime >= STATS_REPORT_TIME) {
+    lastReportTime = millis();
+    report_stats();          // Print performance statistics
+  }
+
+  // Sleep for the period of the current activity; encoder steps and button presses wake the loop early
+  refresh_ctl_update(&refresh, millis(), ui_busy());
+  uint32_t busy_us = micros() - loop_start;
+  PROF_END(PROF_LOOP, loop_ticks);
+  if (PROF_ENABLE) {
+    lvgl_pool_mon_t mon;
+    lvgl_pool_monitor(&mon);
+    prof_counter(PROF_HEAP, mon.used);                     // Heap and refresh queue tracks of the trace
+    prof_counter(PROF_INV_AREAS, lv_disp_get_default()->inv_p);
+  }
+  PROF_BEGIN(sleep_ticks);
+  encoder_wait(refresh_ctl_wait_ms(&refresh));
+  PROF_END(PROF_SLEEP, sleep_ticks);
+  refresh_ctl_account(&refresh, millis(), busy_us, micros() - loop_start, disp_frames != frames_before);
 }
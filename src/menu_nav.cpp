@@ -0,0 +1,56 @@
+/*
+ * Menu navigation step, see menu_nav.h
+ */
+
+#include <string.h>
+#include "encoder.h"
+#include "menu_nav.h"
+
+static menu_nav_stats_t stats;
+
+bool menu_nav_move(lv_obj_t **items, int size, int *cursor, bool *highlighted, int32_t delta, lv_style_t *style) {
+  int next = encoder_wrap(*cursor, delta, size);  // Keep the cursor within 0 to size-1
+  uint32_t styles = 0;
+
+  // Move the selected style straight from the old row to the new one
+  if (next != *cursor || !*highlighted) {
+    if (*highlighted) {
+      lv_obj_remove_style(items[*cursor], style, 0);
+      styles++;
+    }
+    lv_obj_add_style(items[next], style, 0);
+    styles++;
+    *highlighted = true;
+  }
+  *cursor = next;
+
+  stats.frames++;
+  stats.styles += styles;
+  if (styles > stats.max_styles) stats.max_styles = styles;
+  return styles != 0;
+}
+
+void menu_nav_follow(scroll_anim_t *anim, lv_obj_t **scrolled, lv_obj_t *list, lv_obj_t *item, uint32_t now_ms) {
+  // Continue from where the list is when it is another one, or when the animator is idle and
+  // a touch drag may have scrolled it since; its last target would otherwise snap it back
+  if (list != *scrolled || !anim->active) {
+    *scrolled = list;
+    scroll_anim_jump(anim, lv_obj_get_scroll_y(list));
+  }
+
+  lv_coord_t top = lv_obj_get_y(item);                   // Item position in the list content
+  lv_coord_t bottom = top + lv_obj_get_height(item);
+  lv_coord_t view = lv_obj_get_content_height(list);
+  lv_coord_t target = anim->to;                          // Keep heading where we were going if the item fits
+  if (top < target) target = top;
+  else if (bottom > target + view) target = bottom - view;
+  scroll_anim_set_target(anim, target, now_ms);
+}
+
+void menu_nav_get_stats(menu_nav_stats_t *out) {
+  *out = stats;
+}
+
+void menu_nav_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
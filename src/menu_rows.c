@@ -0,0 +1,33 @@
+/*
+ * Lean menu rows, see menu_rows.h
+ */
+
+#include "label_cache.h"
+#include "menu_rows.h"
+
+static const lv_style_const_prop_t selected_props[] = {
+  LV_STYLE_CONST_BG_COLOR(LV_COLOR_MAKE(0xFF, 0x00, 0x00)),
+  LV_STYLE_PROP_INV,
+};
+
+LV_STYLE_CONST_INIT(menu_style_selected, selected_props);
+
+// Mirrors lv_list_add_btn() of LVGL 8.4 except for the static label text
+lv_obj_t *menu_rows_add(lv_obj_t *list, const void *icon, const char *text) {
+  lv_obj_t *btn = lv_list_add_btn(list, icon, NULL);
+  lv_obj_t *label = lv_label_create(btn);
+  lv_label_set_text_static(label, text);
+  lv_label_set_long_mode(label, LV_LABEL_LONG_SCROLL_CIRCULAR);
+  lv_obj_set_flex_grow(label, 1);
+  return btn;
+}
+
+// The image keeps its own size, grown like the label it would be tiled across the row
+lv_obj_t *menu_rows_add_cached(lv_obj_t *list, const void *icon, const char *text) {
+  lv_obj_t *btn = lv_list_add_btn(list, icon, NULL);
+  if (label_cache_create(btn, text) == NULL) {
+    lv_obj_del(btn);
+    btn = menu_rows_add(list, icon, text);
+  }
+  return btn;
+}
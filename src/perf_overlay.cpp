@@ -0,0 +1,83 @@
+/*
+ * Performance overlay, see perf_overlay.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "perf_overlay.h"
+
+#define OVERLAY_WIDTH 140           // Wide enough for the longest line in the 14 px default font
+
+static lv_obj_t *label;
+static lv_timer_t *timer;
+static perf_overlay_sample_cb_t sample_cb;
+static char text[2][PERF_OVERLAY_TEXT];   // The label shows one buffer while the other is written
+static uint8_t shown_buf;
+static bool shown;
+static perf_overlay_stats_t stats;
+
+void perf_overlay_format(char *out, uint32_t size, const perf_overlay_values_t *v) {
+  snprintf(out, size, "%3lu.%lu fps %3lu%% cpu\n%5lu kB/s\nheap %3lu%% %6lu\np95 %4lu.%lu ms",
+           (unsigned long)(v->fps_x10 / 10), (unsigned long)(v->fps_x10 % 10), (unsigned long)v->cpu_pct,
+           (unsigned long)v->flush_kbps, (unsigned long)v->heap_pct, (unsigned long)v->heap_used,
+           (unsigned long)(v->latency_us / 1000), (unsigned long)(v->latency_us % 1000 / 100));
+}
+
+// Timer callback: sample, and touch the label only if the text changed
+static void update(lv_timer_t *t) {
+  perf_overlay_values_t v;
+  sample_cb(&v);
+  stats.updates++;
+
+  char *next = text[shown_buf ^ 1];
+  perf_overlay_format(next, PERF_OVERLAY_TEXT, &v);
+  if (strcmp(next, text[shown_buf]) == 0) return;   // Nothing invalidated
+  shown_buf ^= 1;
+  lv_label_set_text_static(label, next);
+  stats.redraws++;
+  lv_area_t area;
+  lv_obj_get_coords(label, &area);
+  stats.pixels += lv_area_get_size(&area);
+}
+
+void perf_overlay_create(perf_overlay_sample_cb_t sample, bool show) {
+  sample_cb = sample;
+  label = lv_label_create(lv_layer_sys());
+  lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
+  lv_obj_set_width(label, OVERLAY_WIDTH);           // Fixed size: changes never relayout
+  lv_obj_set_style_bg_color(label, lv_color_black(), 0);
+  lv_obj_set_style_bg_opa(label, LV_OPA_COVER, 0);  // Opaque, but LVGL 8.4 still renders the menu under the corner first
+  lv_obj_set_style_text_color(label, lv_color_white(), 0);
+  lv_obj_set_style_pad_all(label, 2, 0);
+  lv_obj_align(label, LV_ALIGN_TOP_RIGHT, 0, 0);
+  lv_label_set_text_static(label, text[shown_buf]);
+
+  timer = lv_timer_create(update, PERF_OVERLAY_PERIOD_MS, NULL);
+  shown = !show;
+  perf_overlay_show(show);
+}
+
+void perf_overlay_show(bool show) {
+  if (!label || show == shown) return;
+  shown = show;
+  if (show) {
+    lv_obj_clear_flag(label, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_resume(timer);
+    lv_timer_ready(timer);                          // First values at the next handler call
+  } else {
+    lv_obj_add_flag(label, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_pause(timer);
+  }
+}
+
+bool perf_overlay_shown(void) {
+  return shown;
+}
+
+void perf_overlay_get_stats(perf_overlay_stats_t *out) {
+  *out = stats;
+}
+
+void perf_overlay_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
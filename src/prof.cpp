@@ -0,0 +1,170 @@
+/*
+ * Hot-path profiler, see prof.h
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "prof.h"
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#define CORE_ID() ((uint8_t)xPortGetCoreID())
+#else
+static thread_local uint8_t thread_core;  // Host threads stand in for cores, see prof_sync_core()
+static uint8_t threads_synced;
+#define CORE_ID() thread_core
+#endif
+
+static_assert((PROF_RECORDS & (PROF_RECORDS - 1)) == 0, "PROF_RECORDS must be a power of two");
+
+#if PROF_ENABLE
+static prof_record_t ring[PROF_RECORDS];
+#else
+static prof_record_t ring[1];             // Nothing is recorded
+#endif
+static uint32_t head;                     // Records claimed since boot
+static volatile bool paused;
+static uint32_t ticks_per_us = 1;
+uint32_t prof_core_offset[2];
+
+static const char *const names[PROF_ID_COUNT] = {
+  "loop", "timer", "flush", "encoder", "button", "scroll", "serial", "sleep", "band", "heap", "inv_areas"
+};
+
+void prof_init(uint32_t rate) {
+  ticks_per_us = rate ? rate : 1;
+  prof_sync_core();
+}
+
+void prof_sync_core(void) {
+#if defined(ESP_PLATFORM)
+  // Sample the cycle counter right at a tick of the microsecond clock, so the
+  // offset is off by one loop iteration rather than up to a whole microsecond
+  int64_t before = esp_timer_get_time(), us;
+  uint32_t cycles;
+  do {
+    cycles = XTHAL_GET_CCOUNT();
+    us = esp_timer_get_time();
+  } while (us == before);
+  prof_core_offset[CORE_ID()] = (uint32_t)((uint64_t)us * ticks_per_us) - cycles;
+#else
+  thread_core = __atomic_fetch_add(&threads_synced, 1, __ATOMIC_RELAXED);   // One clock, so only a number
+#endif
+}
+
+uint32_t prof_ticks_per_us(void) {
+  return ticks_per_us;
+}
+
+static void put(prof_id_t id, uint32_t start, uint32_t ticks) {
+  uint32_t n = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+  prof_record_t *r = &ring[n & (PROF_RECORDS - 1)];
+  r->start = start;
+  r->ticks = ticks;
+  r->id = (uint8_t)id;
+  r->core = CORE_ID();
+  r->seq = (uint16_t)n;
+}
+
+void prof_record(prof_id_t id, uint32_t start) {
+  if (!PROF_ENABLE || paused) return;
+  put(id, start, prof_now() - start);
+}
+
+void prof_counter(prof_id_t id, uint32_t value) {
+  if (!PROF_ENABLE || paused) return;
+  put(id, prof_now(), value);
+}
+
+void prof_pause(bool p) {
+  paused = p;
+}
+
+uint32_t prof_count(void) {
+  uint32_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+  return end < PROF_RECORDS ? end : PROF_RECORDS;
+}
+
+uint32_t prof_read(prof_record_t *out, uint32_t from, uint32_t max) {
+  uint32_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+  uint32_t held = end < PROF_RECORDS ? end : PROF_RECORDS;
+  if (from >= held) return 0;
+  uint32_t n = held - from < max ? held - from : max;
+  for (uint32_t i = 0; i < n; i++) {
+    out[i] = ring[(end - held + from + i) & (PROF_RECORDS - 1)];
+  }
+  return n;
+}
+
+uint32_t prof_total(void) {
+  return head;
+}
+
+const char *prof_name(prof_id_t id) {
+  return id < PROF_ID_COUNT ? names[id] : "?";
+}
+
+// Format into a line buffer and hand it to the sink
+static void writef(prof_write_t write, void *ctx, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+static void writef(prof_write_t write, void *ctx, const char *fmt, ...) {
+  char line[160];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  write(line, ctx);
+}
+
+// One track per core for the timed blocks and one counter track each for the heap and the
+// refresh queue. Same output as tools/trace_to_chrome.py, for captures saved straight from the device.
+void prof_write_chrome(prof_write_t write, void *ctx) {
+  prof_record_t chunk[32];
+  prof_pause(true);
+  write("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", ctx);
+  write("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":0,\"args\":{\"name\":\"dump 0\"}}", ctx);
+
+  // Ticks wrap (after 17 s at 240 MHz): follow them as signed steps from the first record.
+  // Records are written when a block ends, so an enclosing block (the loop) starts before the
+  // first record: a first pass finds the earliest start to count from, and the cores to name.
+  int64_t base = 0;
+  uint8_t cores = 0;                       // Bit per core with timed blocks
+  for (int pass = 0; pass < 2; pass++) {
+    bool first = true;
+    uint32_t last = 0;
+    int64_t t = 0;
+    for (uint32_t from = 0, n; (n = prof_read(chunk, from, 32)) > 0; from += n) {
+      for (uint32_t i = 0; i < n; i++) {
+        const prof_record_t *r = &chunk[i];
+        t = first ? 0 : t + (int32_t)(r->start - last);
+        last = r->start;
+        first = false;
+        prof_id_t id = (prof_id_t)r->id;
+        if (pass == 0) {
+          if (t < base) base = t;
+          if (!prof_is_counter(id)) cores |= 1u << (r->core & 7);
+          continue;
+        }
+        if (prof_is_counter(id)) {
+          writef(write, ctx, ",{\"ph\":\"C\",\"name\":\"%s\",\"pid\":0,\"ts\":%.3f,\"args\":{\"value\":%lu}}",
+                 prof_name(id), (double)(t - base) / ticks_per_us, (unsigned long)r->ticks);
+        } else {
+          writef(write, ctx, ",{\"ph\":\"X\",\"name\":\"%s\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                 prof_name(id), r->core, (double)(t - base) / ticks_per_us, (double)r->ticks / ticks_per_us);
+        }
+      }
+    }
+    if (pass == 0) {
+      if (cores == 0) cores = 1;           // Counters only: the script still names core 0
+      for (int core = 0; core < 8; core++) {
+        if (cores & (1u << core)) {
+          writef(write, ctx, ",{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                 core, core);
+        }
+      }
+    }
+  }
+  write("]}\n", ctx);
+  prof_pause(false);
+}
@@ -0,0 +1,68 @@
+/*
+ * Adaptive refresh controller, see refresh_ctl.h
+ */
+
+#include <string.h>
+#include "refresh_ctl.h"
+
+void refresh_ctl_init(refresh_ctl_t *r, uint32_t active_ms, uint32_t now_ms) {
+  memset(r, 0, sizeof(*r));
+  r->state = REFRESH_IDLE;
+  r->active_ms = active_ms;
+  r->last_input_ms = now_ms - REFRESH_HOLD_MS;
+  r->window_start_ms = now_ms;
+}
+
+void refresh_ctl_activity(refresh_ctl_t *r, uint32_t now_ms) {
+  r->last_input_ms = now_ms;
+}
+
+refresh_state_t refresh_ctl_update(refresh_ctl_t *r, uint32_t now_ms, bool busy) {
+  if (busy) {
+    r->state = REFRESH_ANIMATING;
+  } else if (now_ms - r->last_input_ms < REFRESH_HOLD_MS) {
+    r->state = REFRESH_BROWSING;   // Stay responsive for the next detent
+  } else {
+    r->state = REFRESH_IDLE;
+  }
+  return r->state;
+}
+
+uint32_t refresh_ctl_wait_ms(const refresh_ctl_t *r) {
+  return r->state == REFRESH_IDLE ? REFRESH_IDLE_POLL_MS : r->active_ms;
+}
+
+void refresh_ctl_account(refresh_ctl_t *r, uint32_t now_ms, uint32_t busy_us, uint32_t wall_us, bool flushed) {
+  refresh_state_stats_t *s = &r->stats[r->state];
+  s->loops++;
+  s->busy_us += busy_us;
+  s->wall_us += wall_us;
+  if (flushed) {
+    s->frames++;
+    r->window_frames++;
+  }
+
+  uint32_t elapsed = now_ms - r->window_start_ms;
+  if (elapsed >= REFRESH_RATE_WINDOW_MS) {
+    r->rate_mhz = (uint32_t)((uint64_t)r->window_frames * 1000000u / elapsed);
+    r->window_frames = 0;
+    r->window_start_ms = now_ms;
+  }
+}
+
+uint32_t refresh_ctl_rate_mhz(const refresh_ctl_t *r) {
+  return r->rate_mhz;
+}
+
+const char *refresh_ctl_state_name(refresh_state_t state) {
+  switch (state) {
+    case REFRESH_IDLE: return "idle";
+    case REFRESH_BROWSING: return "browsing";
+    case REFRESH_ANIMATING: return "animating";
+    default: return "?";
+  }
+}
+
+void refresh_ctl_reset_stats(refresh_ctl_t *r) {
+  memset(r->stats, 0, sizeof(r->stats));
+}
@@ -0,0 +1,180 @@
+/*
+ * RGB565 render kernels, see render_kernels.h
+ */
+
+#include <string.h>
+#include "render_kernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Two pixels as one word. The buffers are uint16_t, so word access must be allowed to alias them; the loops
+// align first, which keeps these single 32-bit accesses on the ESP32 (memcpy could not assume the alignment)
+typedef uint32_t __attribute__((__may_alias__)) pixel_pair_t;
+
+// Fill one row, aligning to 32 bits first and writing 8 pixels per iteration
+static inline void fill_row(uint16_t *d, int32_t w, uint16_t color) {
+  if (((uintptr_t)d & 2) && w > 0) {
+    *d++ = color;
+    w--;
+  }
+
+  pixel_pair_t *d32 = (pixel_pair_t *)d;
+  uint32_t pair = (uint32_t)color | ((uint32_t)color << 16);
+  int32_t pairs = w >> 1;
+
+#if defined(__SSE2__)
+  __m128i v = _mm_set1_epi32((int)pair);
+  while (pairs >= 4 && ((uintptr_t)d32 & 15)) {
+    *d32++ = pair;
+    pairs--;
+  }
+  for (; pairs >= 8; pairs -= 8) {
+    _mm_store_si128((__m128i *)d32, v);
+    _mm_store_si128((__m128i *)(d32 + 4), v);
+    d32 += 8;
+  }
+#endif
+
+  for (; pairs >= 4; pairs -= 4) {
+    d32[0] = pair;
+    d32[1] = pair;
+    d32[2] = pair;
+    d32[3] = pair;
+    d32 += 4;
+  }
+  while (pairs--) *d32++ = pair;
+
+  if (w & 1) d[w - 1] = color;
+}
+
+void rgb565_fill(uint16_t *dst, int32_t stride, int32_t w, int32_t h, uint16_t color) {
+  for (int32_t y = 0; y < h; y++) {
+    fill_row(dst, w, color);
+    dst += stride;
+  }
+}
+
+void rgb565_copy(uint16_t *dst, int32_t dst_stride, const uint16_t *src, int32_t src_stride,
+                 int32_t w, int32_t h) {
+  // Contiguous rectangles are copied in one go, otherwise row by row (memcpy moves whole words)
+  if (dst_stride == w && src_stride == w) {
+    memcpy(dst, src, (size_t)w * h * sizeof(uint16_t));
+    return;
+  }
+  for (int32_t y = 0; y < h; y++) {
+    memcpy(dst, src, (size_t)w * sizeof(uint16_t));
+    dst += dst_stride;
+    src += src_stride;
+  }
+}
+
+void rgb565_blend_color(uint16_t *dst, int32_t stride, int32_t w, int32_t h,
+                        rgb565_mix_cb_t mix, void *ctx, uint16_t seed_bg, uint16_t seed_res) {
+  uint16_t last_bg = seed_bg;       // Last background value seen
+  uint16_t last_res = seed_res;     // Its blended result
+
+  for (int32_t y = 0; y < h; y++) {
+    uint16_t *d = dst;
+    int32_t x = 0;
+
+    if (((uintptr_t)d & 2) && w > 0) {
+      if (d[0] != last_bg) {
+        last_bg = d[0];
+        last_res = mix(last_bg, ctx);
+      }
+      d[0] = last_res;
+      x = 1;
+    }
+
+    // Two pixels per iteration; a pair equal to the cached background is written in one store
+    for (; x + 1 < w; x += 2) {
+      pixel_pair_t *p = (pixel_pair_t *)(d + x);
+      uint32_t bg_pair = (uint32_t)last_bg | ((uint32_t)last_bg << 16);
+      if (*p == bg_pair) {
+        *p = (uint32_t)last_res | ((uint32_t)last_res << 16);
+        continue;
+      }
+      for (int32_t i = 0; i < 2; i++) {
+        if (d[x + i] != last_bg) {
+          last_bg = d[x + i];
+          last_res = mix(last_bg, ctx);
+        }
+        d[x + i] = last_res;
+      }
+    }
+
+    if (x < w) {
+      if (d[x] != last_bg) {
+        last_bg = d[x];
+        last_res = mix(last_bg, ctx);
+      }
+      d[x] = last_res;
+    }
+
+    dst += stride;
+  }
+}
+
+// RGB565 -> RGB444 for the two pixels in a 32-bit word (the shifts never cross the 16-bit lanes under the masks)
+static inline uint32_t pair_to_444(uint32_t w) {
+  return ((w >> 4) & 0x0F000F00u) | ((w >> 3) & 0x00F000F0u) | ((w >> 1) & 0x000F000Fu);
+}
+
+// Swap the bytes of both pixels in a 32-bit word
+static inline uint32_t pair_swap(uint32_t w) {
+  return ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+}
+
+uint32_t rgb565_pack444(uint8_t *dst, const uint16_t *src, int32_t n, bool swapped) {
+  uint8_t *d = dst;
+  int32_t i = 0;
+
+  // Two pixels per 32-bit load (memcpy keeps the load legal for any alignment)
+  for (; i + 1 < n; i += 2) {
+    uint32_t w;
+    memcpy(&w, src + i, sizeof(w));
+    if (swapped) w = pair_swap(w);
+    uint32_t q = pair_to_444(w);
+    uint32_t a = q & 0xFFF;
+    uint32_t b = q >> 16;
+    d[0] = (uint8_t)(a >> 4);
+    d[1] = (uint8_t)((a << 4) | (b >> 8));
+    d[2] = (uint8_t)b;
+    d += 3;
+  }
+
+  if (i < n) {
+    uint32_t c = src[i];
+    if (swapped) c = pair_swap(c);
+    uint32_t a = pair_to_444(c);
+    d[0] = (uint8_t)(a >> 4);
+    d[1] = (uint8_t)(a << 4);
+    d += 2;
+  }
+  return (uint32_t)(d - dst);
+}
+
+void rgb565_error444(const uint16_t *src, int32_t n, bool swapped, rgb444_error_t *acc) {
+  for (int32_t i = 0; i < n; i++) {
+    uint32_t c = src[i];
+    if (swapped) c = pair_swap(c);
+    // 8-bit channels as the panel shows them in 16-bit and in 12-bit mode
+    uint8_t r5 = c >> 11, g6 = (c >> 5) & 0x3F, b5 = c & 0x1F;
+    uint8_t full[3] = {(uint8_t)((r5 << 3) | (r5 >> 2)), (uint8_t)((g6 << 2) | (g6 >> 4)), (uint8_t)((b5 << 3) | (b5 >> 2))};
+    uint8_t r4 = r5 >> 1, g4 = g6 >> 2, b4 = b5 >> 1;
+    uint8_t low[3] = {(uint8_t)(r4 * 17), (uint8_t)(g4 * 17), (uint8_t)(b4 * 17)};
+
+    bool changed = false;
+    for (int k = 0; k < 3; k++) {
+      uint8_t e = full[k] > low[k] ? full[k] - low[k] : low[k] - full[k];
+      acc->sum_abs += e;
+      acc->sum_sq += e * e;
+      if (e > acc->max) acc->max = e;
+      if (e) changed = true;
+    }
+    acc->pixels++;
+    if (changed) acc->changed++;
+  }
+}
@@ -0,0 +1,129 @@
+/*
+ * Run-length encoded image decoder, see rle_img.h
+ */
+
+#include "rle_img.h"
+
+#define RLE_PIXEL_BYTES 3         // RGB565 little endian + alpha
+#define RLE_RUN 0x80              // Packet flag: one pixel repeated
+
+static rle_img_stats_t stats;
+
+// Write one encoded pixel in the byte order of lv_color_t
+static inline void put_pixel(uint8_t *out, const uint8_t *px) {
+#if LV_COLOR_16_SWAP
+  out[0] = px[1];
+  out[1] = px[0];
+#else
+  out[0] = px[0];
+  out[1] = px[1];
+#endif
+  out[2] = px[2];
+}
+
+bool rle_img_is_rle(const lv_img_dsc_t *img) {
+  return img->header.cf == LV_IMG_CF_RAW_ALPHA && img->data_size >= 4 &&
+         memcmp(img->data, RLE_IMG_MAGIC, 4) == 0;
+}
+
+// Bytes in front of the packets: the magic and the row offset table
+static uint32_t table_bytes(const lv_img_dsc_t *img) {
+  return 4 + (uint32_t)img->header.h * 2;
+}
+
+bool rle_img_decode_line(const lv_img_dsc_t *img, int32_t x, int32_t y, int32_t len, uint8_t *out) {
+  if (y < 0 || y >= (int32_t)img->header.h || x < 0 || len < 0 || x + len > (int32_t)img->header.w) return false;
+
+  // Positions are checked against data_size, so a corrupt table or stream cannot read past the image
+  const uint8_t *data = img->data;
+  uint32_t size = img->data_size;
+  uint32_t table = table_bytes(img);
+  if (table > size) return false;
+  uint32_t offset = data[4 + y * 2] | (data[4 + y * 2 + 1] << 8);
+  if (offset >= size - table) return false;
+  uint32_t pos = table + offset;
+  int32_t col = 0;
+
+  // Skip whole packets left of x
+  for (;;) {
+    if (pos >= size) return false;
+    int32_t n = (data[pos] & 0x7F) + 1;
+    if (col + n > x) break;
+    pos += 1 + ((data[pos] & RLE_RUN) ? RLE_PIXEL_BYTES : n * RLE_PIXEL_BYTES);
+    col += n;
+  }
+
+  // Emit packets, starting part-way into the first one
+  int32_t skip = x - col;
+  while (len > 0) {
+    if (pos >= size) return false;
+    uint8_t tag = data[pos++];
+    int32_t count = (tag & 0x7F) + 1;
+    uint32_t bytes = (tag & RLE_RUN) ? RLE_PIXEL_BYTES : count * RLE_PIXEL_BYTES;
+    if (bytes > size - pos) return false;   // Packet runs past the end of the stream
+    const uint8_t *p = data + pos;
+    int32_t n = count - skip;
+    if (n > len) n = len;
+    if (tag & RLE_RUN) {
+      for (int32_t i = 0; i < n; i++, out += RLE_PIXEL_BYTES) put_pixel(out, p);
+    } else {
+      const uint8_t *px = p + skip * RLE_PIXEL_BYTES;
+      for (int32_t i = 0; i < n; i++, out += RLE_PIXEL_BYTES, px += RLE_PIXEL_BYTES) put_pixel(out, px);
+    }
+    pos += bytes;
+    len -= n;
+    skip = 0;
+  }
+  return true;
+}
+
+// info_cb: claim RLE images and describe them as true colour with alpha
+static lv_res_t rle_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header) {
+  if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+  const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+  if (!rle_img_is_rle(img)) return LV_RES_INV;
+  *header = img->header;
+  header->cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+  return LV_RES_OK;
+}
+
+// open_cb: leave img_data NULL so LVGL reads the image line by line
+static lv_res_t rle_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+  if (dsc->src_type != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+  const lv_img_dsc_t *img = (const lv_img_dsc_t *)dsc->src;
+  if (!rle_img_is_rle(img) || table_bytes(img) > img->data_size) return LV_RES_INV;   // Truncated offset table
+  dsc->img_data = NULL;
+  return LV_RES_OK;
+}
+
+// read_line_cb: decode straight into LVGL's line buffer
+static lv_res_t rle_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc, lv_coord_t x, lv_coord_t y,
+                              lv_coord_t len, uint8_t *buf) {
+  uint32_t start = ESP.getCycleCount();
+  bool ok = rle_img_decode_line((const lv_img_dsc_t *)dsc->src, x, y, len, buf);
+  stats.cycles += ESP.getCycleCount() - start;
+  if (!ok) return LV_RES_INV;   // Out of the image, or a corrupt stream
+  stats.lines++;
+  stats.pixels += len;
+  return LV_RES_OK;
+}
+
+// close_cb: nothing was allocated
+static void rle_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+}
+
+void rle_img_init(void) {
+  lv_img_decoder_t *dec = lv_img_decoder_create();
+  lv_img_decoder_set_info_cb(dec, rle_info);
+  lv_img_decoder_set_open_cb(dec, rle_open);
+  lv_img_decoder_set_read_line_cb(dec, rle_read_line);
+  lv_img_decoder_set_close_cb(dec, rle_close);
+}
+
+void rle_img_get_stats(rle_img_stats_t *out) {
+  *out = stats;
+}
+
+void rle_img_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
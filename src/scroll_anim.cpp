@@ -0,0 +1,65 @@
+/*
+ * Encoder scroll animator, see scroll_anim.h
+ */
+
+#include <string.h>
+#include "scroll_anim.h"
+
+#define EASE_ONE 1024               // 1.0 in the Q10 ease curve
+
+// Ease-out cubic, Q10 progress in and out
+static int32_t ease_out(int32_t p) {
+  int32_t inv = EASE_ONE - p;
+  return EASE_ONE - (int32_t)((int64_t)inv * inv * inv / ((int64_t)EASE_ONE * EASE_ONE));
+}
+
+void scroll_anim_init(scroll_anim_t *a, uint16_t frame_ms, int32_t pos) {
+  memset(a, 0, sizeof(*a));
+  a->frame_ms = frame_ms ? frame_ms : 1;
+  a->from = a->to = a->pos = pos;
+}
+
+void scroll_anim_jump(scroll_anim_t *a, int32_t pos) {
+  a->from = a->to = a->pos = pos;
+  a->active = false;
+}
+
+void scroll_anim_set_target(scroll_anim_t *a, int32_t target, uint32_t now_ms) {
+  if (target == a->to) return;      // Already heading there, keep the curve
+  if (!a->active) a->last_ms = now_ms;
+  a->from = a->pos;
+  a->to = target;
+  a->start_ms = now_ms;
+  a->active = true;
+}
+
+bool scroll_anim_step(scroll_anim_t *a, uint32_t now_ms, int32_t *pos) {
+  if (!a->active) return false;
+
+  // Every whole frame period beyond the first since the last offset is a dropped frame
+  uint32_t dt = now_ms - a->last_ms;
+  if (dt > a->frame_ms + a->frame_ms / 2) a->stats.dropped += dt / a->frame_ms - 1;
+  a->stats.active_ms += dt;
+  a->stats.frames++;
+  a->last_ms = now_ms;
+
+  uint32_t duration = (uint32_t)a->frame_ms * SCROLL_ANIM_FRAMES;
+  uint32_t t = now_ms - a->start_ms;
+  int32_t next;
+  if (t >= duration) {
+    next = a->to;
+    a->active = false;
+  } else {
+    int32_t p = (int32_t)(t * EASE_ONE / duration);
+    next = a->from + (int32_t)((int64_t)(a->to - a->from) * ease_out(p) / EASE_ONE);
+  }
+
+  bool changed = next != a->pos;
+  a->pos = next;
+  *pos = next;
+  return changed;
+}
+
+void scroll_anim_reset_stats(scroll_anim_t *a) {
+  memset(&a->stats, 0, sizeof(a->stats));
+}
@@ -0,0 +1,170 @@
+/*
+ * Shadow framebuffer, see shadow_fb.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "shadow_fb.h"
+
+#if defined(ESP_PLATFORM)
+#include <esp_heap_caps.h>
+#endif
+
+// Two pixels as one word, allowed to alias the uint16_t buffers
+typedef uint32_t __attribute__((__may_alias__)) pixel_pair_t;
+
+static uint16_t *shadow;              // Copy of the panel content
+static uint16_t fb_width, fb_height;
+static uint32_t (*clock_us)(void);    // Time source for the statistics
+static shadow_fb_stats_t stats;
+
+bool shadow_fb_init(uint16_t width, uint16_t height, uint16_t color, uint32_t (*now_us)(void)) {
+  size_t bytes = (size_t)width * height * sizeof(uint16_t);
+#if defined(ESP_PLATFORM)
+  shadow = (uint16_t *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);   // PSRAM if fitted
+  if (!shadow && SHADOW_FB_INTERNAL) shadow = (uint16_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+  shadow = (uint16_t *)malloc(bytes);
+#endif
+  if (!shadow) return false;
+
+  fb_width = width;
+  fb_height = height;
+  clock_us = now_us;
+  for (size_t i = 0; i < (size_t)width * height; i++) shadow[i] = color;
+  return true;
+}
+
+bool shadow_fb_active(void) {
+  return shadow != NULL;
+}
+
+// Length of the run of equal pixels starting at a/b, up to n pixels (two pixels per compare when aligned)
+static int32_t same_run(const uint16_t *a, const uint16_t *b, int32_t n) {
+  int32_t i = 0;
+  if ((((uintptr_t)a ^ (uintptr_t)b) & 2) == 0) {
+    if (((uintptr_t)a & 2) && n > 0) {
+      if (a[0] != b[0]) return 0;
+      i = 1;
+    }
+    for (; i + 1 < n; i += 2) {
+      if (*(const pixel_pair_t *)(a + i) != *(const pixel_pair_t *)(b + i)) break;
+    }
+  }
+  while (i < n && a[i] == b[i]) i++;
+  return i;
+}
+
+// Length of the run of different pixels starting at a/b, up to n pixels
+static int32_t diff_run(const uint16_t *a, const uint16_t *b, int32_t n) {
+  int32_t i = 0;
+  while (i < n && a[i] != b[i]) i++;
+  return i;
+}
+
+// Changed runs of one row after gap merging; returns the run count, or -1 if there are too many to send separately
+static int32_t row_runs(const uint16_t *src, const uint16_t *dst, int32_t w, int32_t *run_x, int32_t *run_w) {
+  int32_t n = 0;
+  int32_t px = 0;
+  while (px < w) {
+    px += same_run(src + px, dst + px, w - px);
+    if (px >= w) break;
+    int32_t d = diff_run(src + px, dst + px, w - px);
+    if (n > 0 && px - (run_x[n - 1] + run_w[n - 1]) <= (int32_t)SHADOW_FB_MERGE_GAP) {
+      run_w[n - 1] = px + d - run_x[n - 1];   // Extend the previous run over the gap
+    } else {
+      if (n == SHADOW_FB_MAX_RUNS) return -1;
+      run_x[n] = px;
+      run_w[n] = d;
+      n++;
+    }
+    px += d;
+  }
+  return n;
+}
+
+uint32_t shadow_fb_update(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels,
+                          shadow_fb_send_cb_t send, void *ctx) {
+  int32_t run_x[SHADOW_FB_MAX_RUNS], run_w[SHADOW_FB_MAX_RUNS];
+  int32_t block_y = -1;               // First row of a group of fully changed rows not sent yet
+  uint32_t sent = 0;
+  uint32_t spent = 0;                 // Time inside send callbacks, excluded from the diff time
+  uint32_t start = clock_us ? clock_us() : 0;
+
+  for (int32_t row = 0; row <= h; row++) {
+    const uint16_t *src = NULL;
+    uint16_t *dst = NULL;
+    int32_t n = 0;
+    bool full = false;
+    if (row < h) {                    // Row h only sends the last group; it has no pixels
+      src = pixels + row * w;
+      dst = shadow + (size_t)(y + row) * fb_width + x;
+      n = row_runs(src, dst, w, run_x, run_w);
+      full = n < 0 || (n == 1 && run_w[0] == w);   // Too fragmented rows are sent whole
+    }
+
+    // Fully changed rows are grouped and go out as one rectangle
+    if (full) {
+      if (block_y < 0) block_y = row;
+      memcpy(dst, src, w * sizeof(uint16_t));
+      continue;
+    }
+
+    uint32_t t = clock_us ? clock_us() : 0;
+    if (block_y >= 0) {
+      send(x, y + block_y, w, row - block_y, pixels + block_y * w, ctx);
+      stats.spans++;
+      sent += (row - block_y) * w;
+      block_y = -1;
+    }
+    for (int32_t i = 0; i < n; i++) {
+      send(x + run_x[i], y + row, run_w[i], 1, src + run_x[i], ctx);
+      stats.spans++;
+      sent += run_w[i];
+    }
+    if (clock_us) spent += clock_us() - t;
+
+    if (n > 0) memcpy(dst, src, w * sizeof(uint16_t));
+  }
+
+  stats.pixels_in += w * h;
+  stats.pixels_sent += sent;
+  if (clock_us) stats.diff_us += clock_us() - start - spent;
+  return sent;
+}
+
+bool shadow_fb_fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+  uint32_t start = clock_us ? clock_us() : 0;
+  bool changed = false;
+  for (int32_t row = 0; row < h; row++) {
+    uint16_t *dst = shadow + (size_t)(y + row) * fb_width + x;
+    for (int32_t i = 0; i < w; i++) {
+      if (dst[i] != color) {
+        changed = true;
+        dst[i] = color;
+      }
+    }
+  }
+  stats.pixels_in += w * h;
+  if (changed) {
+    stats.pixels_sent += w * h;
+    stats.spans++;
+  }
+  if (clock_us) stats.diff_us += clock_us() - start;
+  return changed;
+}
+
+void shadow_fb_store(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels) {
+  if (!shadow) return;
+  for (int32_t row = 0; row < h; row++) {
+    memcpy(shadow + (size_t)(y + row) * fb_width + x, pixels + row * w, w * sizeof(uint16_t));
+  }
+}
+
+void shadow_fb_get_stats(shadow_fb_stats_t *out) {
+  *out = stats;
+}
+
+void shadow_fb_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
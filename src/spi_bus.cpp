@@ -0,0 +1,211 @@
+/*
+ * Shared SPI bus scheduler, see spi_bus.h
+ */
+
+#include <string.h>
+#include "spi_bus.h"
+#include "render_kernels.h"
+
+#define FILL_PATTERN_PIXELS 64u                    // Fill colour pixels packed at once in RGB444 mode
+
+static TFT_eSPI *bus_tft;                          // Display driver owning the bus
+static spi_bus_job_cb_t touch_job;                 // Touch sampling job
+static uint32_t touch_period_us = SPI_BUS_TOUCH_PERIOD_US;
+static uint32_t touch_last_us;                     // Start of the last touch job
+static spi_bus_stats_t stats[SPI_BUS_CLIENTS];     // Per-client accounting
+static uint32_t window_start_us;                   // Start of the statistics window
+static spi_bus_format_t wire_format;               // Pixel format the panel expects
+static uint8_t pack_buf[SPI_BUS_CHUNK_PIXELS * 3 / 2 + 2] __attribute__((aligned(4))); // One packed RGB444 chunk
+
+// Record one job of a client
+static void account(spi_bus_client_t client, uint32_t busy_us, uint32_t wait_us) {
+  spi_bus_stats_t *s = &stats[client];
+  s->jobs++;
+  s->busy_us += busy_us;
+  s->wait_us += wait_us;
+  if (wait_us > s->max_wait_us) s->max_wait_us = wait_us;
+}
+
+void spi_bus_init(TFT_eSPI *tft) {
+  bus_tft = tft;
+#if SPI_BUS_USE_DMA
+  bus_tft->initDMA();             // DMA channel for native-order transfers
+  bus_tft->setSwapBytes(false);   // pushPixelsDMA must not swap in place
+#endif
+  spi_bus_reset_stats();
+}
+
+void spi_bus_set_format(spi_bus_format_t format) {
+  bus_tft->startWrite();
+  bus_tft->writecommand(0x3A);   // COLMOD: interface pixel format
+  bus_tft->writedata(format == SPI_BUS_RGB444 ? SPI_BUS_COLMOD_RGB444 : SPI_BUS_COLMOD_RGB565);
+  bus_tft->endWrite();
+  wire_format = format;
+}
+
+spi_bus_format_t spi_bus_format(void) {
+  return wire_format;
+}
+
+// Send packed bytes inside the current write transaction, by DMA when they fill whole 16-bit words
+static void push_bytes(uint8_t *data, uint32_t len) {
+#if SPI_BUS_USE_DMA
+  if ((len & 1) == 0) {
+    bus_tft->pushPixelsDMA((uint16_t *)data, len / 2);   // Bytes go out in memory order
+    bus_tft->dmaWait();
+    return;
+  }
+#endif
+  bus_tft->pushColors(data, len);
+}
+
+// Pack and send n pixels as RGB444; pieces keep an even pixel count so the stream stays aligned
+static uint32_t push_444(const uint16_t *pixels, uint32_t n, bool swapped) {
+  uint32_t bytes = 0;
+  while (n > 0) {
+    uint32_t piece = n < SPI_BUS_CHUNK_PIXELS ? n : SPI_BUS_CHUNK_PIXELS & ~1u;
+    uint32_t len = rgb565_pack444(pack_buf, pixels, piece, swapped);
+    push_bytes(pack_buf, len);
+    bytes += len;
+    pixels += piece;
+    n -= piece;
+  }
+  return bytes;
+}
+
+void spi_bus_set_touch_job(spi_bus_job_cb_t job, uint32_t period_us) {
+  touch_job = job;
+  touch_period_us = period_us;
+  touch_last_us = micros() - period_us;   // First call runs immediately
+}
+
+// Run the touch job when its period has elapsed; held_us is how long a display chunk has held the bus
+// up to this slot (0 outside a transfer). The bus must be free (no open write transaction).
+static bool touch_run(bool force, uint32_t held_us) {
+  if (!touch_job) return false;
+
+  uint32_t now = micros();
+  uint32_t since = now - touch_last_us;
+  if (!force && since < touch_period_us) return false;
+
+  // The touch client waited only while it was due and a display chunk held the bus: from the later
+  // of the due point and the chunk start. Lateness of an idle loop is not bus contention.
+  uint32_t late = since > touch_period_us ? since - touch_period_us : 0;
+  uint32_t wait = force ? 0 : late < held_us ? late : held_us;
+
+  touch_last_us = now;
+  touch_job();
+  account(SPI_BUS_TOUCH, micros() - now, wait);
+  return true;
+}
+
+bool spi_bus_touch_service(bool force) {
+  return touch_run(force, 0);
+}
+
+// Push a rectangle to the panel in chunks of whole rows, giving the touch job a slot between chunks
+void spi_bus_push_pixels(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *pixels, bool swap) {
+  uint32_t start = micros();
+  uint32_t waited = 0;
+  uint32_t bytes = 0;
+
+  int32_t rows_per_chunk = SPI_BUS_CHUNK_PIXELS / w;
+  if (rows_per_chunk < 1) rows_per_chunk = 1;
+
+  for (int32_t row = 0; row < h; row += rows_per_chunk) {
+    int32_t rows = h - row < rows_per_chunk ? h - row : rows_per_chunk;
+    uint16_t *chunk = pixels + row * w;
+    uint32_t chunk_start = micros();
+
+    bus_tft->startWrite();                               // Take the bus for this chunk
+    bus_tft->setAddrWindow(x, y + row, w, rows);         // Window covering the chunk rows
+    if (wire_format == SPI_BUS_RGB444) {
+      bytes += push_444(chunk, w * rows, !swap);         // Pack to 12 bits while sending
+    } else {
+      bytes += w * rows * 2;
+#if SPI_BUS_USE_DMA
+      if (!swap) {
+        bus_tft->pushPixelsDMA(chunk, w * rows);         // Send the chunk untouched by DMA
+        bus_tft->dmaWait();                              // Touch needs the bus afterwards
+      } else
+#endif
+      {
+        bus_tft->pushColors(chunk, w * rows, swap);      // Send the chunk, swapping bytes if asked
+      }
+    }
+    bus_tft->endWrite();                                 // Release the bus
+
+    // Touch slot between chunks; the display waits while it runs
+    if (row + rows < h) {
+      uint32_t t = micros();
+      if (touch_run(false, t - chunk_start)) waited += micros() - t;
+    }
+  }
+
+  account(SPI_BUS_DISPLAY, micros() - start - waited, waited);
+  stats[SPI_BUS_DISPLAY].bytes += bytes;
+}
+
+void spi_bus_fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+  uint32_t start = micros();
+  uint32_t waited = 0;
+  uint32_t bytes = 0;
+
+  // RGB444 has no repeated-colour burst: repeat a packed run of the colour instead
+  static uint16_t pattern[FILL_PATTERN_PIXELS];
+  if (wire_format == SPI_BUS_RGB444) {
+    for (uint32_t i = 0; i < FILL_PATTERN_PIXELS; i++) pattern[i] = color;
+  }
+
+  int32_t rows_per_chunk = SPI_BUS_CHUNK_PIXELS / w;
+  if (rows_per_chunk < 1) rows_per_chunk = 1;
+
+  for (int32_t row = 0; row < h; row += rows_per_chunk) {
+    int32_t rows = h - row < rows_per_chunk ? h - row : rows_per_chunk;
+    uint32_t chunk_start = micros();
+
+    bus_tft->startWrite();
+    bus_tft->setAddrWindow(x, y + row, w, rows);
+    if (wire_format == SPI_BUS_RGB444) {
+      for (uint32_t n = w * rows; n > 0;) {
+        uint32_t piece = n < FILL_PATTERN_PIXELS ? n : FILL_PATTERN_PIXELS;
+        bytes += push_444(pattern, piece, false);        // pushBlock colours are in CPU order
+        n -= piece;
+      }
+    } else {
+      bus_tft->pushBlock(color, w * rows);   // Repeated-colour burst
+      bytes += w * rows * 2;
+    }
+    bus_tft->endWrite();
+
+    if (row + rows < h) {
+      uint32_t t = micros();
+      if (touch_run(false, t - chunk_start)) waited += micros() - t;
+    }
+  }
+
+  account(SPI_BUS_DISPLAY, micros() - start - waited, waited);
+  stats[SPI_BUS_DISPLAY].bytes += bytes;
+}
+
+void spi_bus_get_stats(spi_bus_client_t client, spi_bus_stats_t *out) {
+  *out = stats[client];
+}
+
+void spi_bus_reset_stats(void) {
+  memset(stats, 0, sizeof(stats));
+  window_start_us = micros();
+}
+
+void spi_bus_report(Print &out) {
+  static const char *const names[SPI_BUS_CLIENTS] = {"display", "touch"};
+  uint32_t window = micros() - window_start_us;
+  if (window == 0) window = 1;
+
+  for (int i = 0; i < SPI_BUS_CLIENTS; i++) {
+    const spi_bus_stats_t *s = &stats[i];
+    out.printf("spi %-7s jobs=%lu util=%.1f%% wait=%luus max_wait=%luus bytes=%lu\n", names[i],
+               (unsigned long)s->jobs, 100.0f * s->busy_us / window,
+               (unsigned long)s->wait_us, (unsigned long)s->max_wait_us, (unsigned long)s->bytes);
+  }
+}
@@ -0,0 +1,143 @@
+/*
+ * Touch filter pipeline, see touch_filter.h
+ */
+
+#include <string.h>
+#include "touch_filter.h"
+
+// Absolute value for small integers
+static inline int32_t iabs(int32_t v) {
+  return v < 0 ? -v : v;
+}
+
+// Median of the first n entries of src (n <= TOUCH_FILTER_MAX_N), insertion sort on a copy
+static int16_t median_of(const int16_t *src, uint8_t n) {
+  int16_t tmp[TOUCH_FILTER_MAX_N];
+  for (uint8_t i = 0; i < n; i++) {
+    int16_t v = src[i];
+    int8_t j = i - 1;
+    while (j >= 0 && tmp[j] > v) {
+      tmp[j + 1] = tmp[j];
+      j--;
+    }
+    tmp[j + 1] = v;
+  }
+  return tmp[n / 2];
+}
+
+// Fill a config structure with the compile-time defaults
+void touch_filter_default_cfg(touch_filter_cfg_t *cfg) {
+  cfg->median_n = TOUCH_FILTER_MEDIAN_N;
+  cfg->iir_shift = TOUCH_FILTER_IIR_SHIFT;
+  cfg->deadzone = TOUCH_FILTER_DEADZONE;
+  cfg->release_n = TOUCH_FILTER_RELEASE_N;
+  cfg->z_threshold = TOUCH_FILTER_Z_THRESHOLD;
+  cfg->outlier = TOUCH_FILTER_OUTLIER;
+}
+
+// Initialise a filter instance, falling back to the defaults when cfg is NULL
+void touch_filter_init(touch_filter_t *f, const touch_filter_cfg_t *cfg) {
+  memset(f, 0, sizeof(*f));
+  if (cfg) {
+    f->cfg = *cfg;
+  } else {
+    touch_filter_default_cfg(&f->cfg);
+  }
+
+  // Keep the window odd and inside the static buffers
+  if (f->cfg.median_n == 0) f->cfg.median_n = 1;
+  if (f->cfg.median_n > TOUCH_FILTER_MAX_N) f->cfg.median_n = TOUCH_FILTER_MAX_N;
+  if ((f->cfg.median_n & 1) == 0) f->cfg.median_n--;
+  if (f->cfg.iir_shift > 7) f->cfg.iir_shift = 7;
+  if (f->cfg.release_n == 0) f->cfg.release_n = 1;
+}
+
+// Forget the sample history (used on release)
+void touch_filter_reset(touch_filter_t *f) {
+  f->count = 0;
+  f->head = 0;
+  f->missing = 0;
+  f->rejects = 0;
+  f->pressed = false;
+}
+
+bool touch_filter_update(touch_filter_t *f, bool touched, int16_t x, int16_t y, uint16_t z,
+                         int16_t *out_x, int16_t *out_y) {
+  const touch_filter_cfg_t *cfg = &f->cfg;
+  f->stats.samples++;
+
+  if (touched && z < cfg->z_threshold) {
+    f->stats.low_pressure++;   // Too light to be a real press
+    touched = false;
+  }
+
+  if (!touched) {
+    // Ride out short dropouts, then report a release and forget the history
+    if (++f->missing >= cfg->release_n) touch_filter_reset(f);
+    *out_x = f->out_x;
+    *out_y = f->out_y;
+    return f->pressed;
+  }
+  f->missing = 0;
+
+  // Hold the output on samples that jump too far from the current median (glitches at
+  // press/release edges). They still enter the window: a single spike is outvoted by the
+  // median, while a real fast move wins the window after half of it and is followed again.
+  bool outlier = false;
+  if (f->count >= cfg->median_n) {
+    int16_t mx = median_of(f->hist_x, f->count);
+    int16_t my = median_of(f->hist_y, f->count);
+    outlier = iabs(x - mx) > cfg->outlier || iabs(y - my) > cfg->outlier;
+  }
+
+  // Push the sample into the median window
+  f->hist_x[f->head] = x;
+  f->hist_y[f->head] = y;
+  f->head = (f->head + 1) % cfg->median_n;
+  if (f->count < cfg->median_n) f->count++;
+
+  if (outlier && f->rejects < cfg->median_n / 2) {
+    f->rejects++;
+    f->stats.outliers++;
+    *out_x = f->out_x;
+    *out_y = f->out_y;
+    return f->pressed;
+  }
+  f->rejects = 0;
+
+  // A press is only reported once half the window agrees, which filters single-sample spikes
+  if (f->count <= cfg->median_n / 2) {
+    *out_x = f->out_x;
+    *out_y = f->out_y;
+    return f->pressed;
+  }
+
+  int32_t mx = median_of(f->hist_x, f->count);
+  int32_t my = median_of(f->hist_y, f->count);
+
+  if (!f->pressed) {
+    // New press: seed the IIR and report the median straight away
+    f->acc_x = mx << 8;
+    f->acc_y = my << 8;
+    f->out_x = (int16_t)mx;
+    f->out_y = (int16_t)my;
+    f->pressed = true;
+  } else {
+    f->acc_x += ((mx << 8) - f->acc_x) >> cfg->iir_shift;
+    f->acc_y += ((my << 8) - f->acc_y) >> cfg->iir_shift;
+    int32_t fx = (f->acc_x + 128) >> 8;
+    int32_t fy = (f->acc_y + 128) >> 8;
+
+    // Only move the reported point once the finger leaves the dead-zone
+    if (iabs(fx - f->out_x) > cfg->deadzone || iabs(fy - f->out_y) > cfg->deadzone) {
+      f->out_x = (int16_t)fx;
+      f->out_y = (int16_t)fy;
+    } else {
+      f->stats.deadzone_holds++;
+    }
+  }
+
+  *out_x = f->out_x;
+  *out_y = f->out_y;
+  return true;
+}
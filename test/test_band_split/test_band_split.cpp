@@ -0,0 +1,126 @@
+/*
+ * Two-core band rendering (pio test -e native)
+ *
+ * Whatever break-even area the boot calibration picks, a kernel call must
+ * leave the same pixels whether it ran on one core or in two bands. Each
+ * test renders the same input once with splitting off and once with it
+ * forced on, for every row count the draw buffer can hand over, and
+ * compares the buffers bit for bit.
+ */
+
+#include <string.h>
+#include <lvgl.h>
+#include <unity.h>
+#include "band_split.h"
+#include "render_kernels.h"
+
+#define W 320                   // Screen width
+#define H 240                   // Screen height
+#define BUF_ROWS 10             // Rows of the firmware's draw buffer
+
+// Kernels a band job can run, like the draw hooks' kernel_band()
+typedef enum { FILL, COPY, BLEND } kernel_t;
+
+typedef struct {
+  kernel_t kernel;
+  uint16_t *dest;
+  const uint16_t *src;
+  int32_t w;
+  lv_color_t color;
+  lv_opa_t opa;
+} job_t;
+
+static uint16_t single[W * H], split[W * H], source[W * H];
+
+void setUp(void) {
+  band_split_reset_stats();
+}
+
+void tearDown(void) {
+  band_split_set_threshold(BAND_SPLIT_MIN_PIXELS);
+}
+
+static uint16_t mix(uint16_t bg, void *ctx) {
+  const job_t *j = (const job_t *)ctx;
+  lv_color_t c;
+  c.full = bg;
+  return lv_color_mix(j->color, c, j->opa).full;
+}
+
+static void band(int32_t y0, int32_t y1, void *ctx) {
+  const job_t *j = (const job_t *)ctx;
+  uint16_t *dest = j->dest + y0 * W;
+  switch (j->kernel) {
+    case FILL:
+      rgb565_fill(dest, W, j->w, y1 - y0, j->color.full);
+      break;
+    case COPY:
+      rgb565_copy(dest, W, j->src + y0 * W, W, j->w, y1 - y0);
+      break;
+    default:
+      rgb565_blend_color(dest, W, j->w, y1 - y0, mix, (void *)j, j->color.full, mix(j->color.full, (void *)j));
+      break;
+  }
+}
+
+// Rows of list-like content: stripes of a few colours, so blends see changing backgrounds
+static void draw_pattern(uint16_t *buf, uint32_t seed) {
+  for (uint32_t i = 0; i < W * H; i++) {
+    seed = seed * 1103515245u + 12345u;
+    buf[i] = (i / 7) % 5 == 0 ? (uint16_t)(seed >> 16) : (uint16_t)(0xFFFF - (i / W) * 0x0841);
+  }
+}
+
+// Run job over rows with splitting off and on, from the same input, and compare
+static void render_both(kernel_t kernel, int32_t rows) {
+  draw_pattern(single, 1);
+  memcpy(split, single, sizeof(single));
+  job_t j = {kernel, single, source, W - 1, LV_COLOR_MAKE(0x20, 0x80, 0xF0), 100};   // Odd width: a trailing pixel
+
+  band_split_set_threshold(UINT32_MAX);
+  TEST_ASSERT_FALSE(band_split_run(rows, W * rows, band, &j));
+  j.dest = split;
+  band_split_set_threshold(0);
+  TEST_ASSERT_TRUE(band_split_run(rows, W * rows, band, &j));
+  TEST_ASSERT_EQUAL_MEMORY(single, split, sizeof(single));
+}
+
+static void test_fill_split_matches_single_core(void) {
+  for (int32_t rows = 2; rows <= BUF_ROWS; rows++) render_both(FILL, rows);
+  render_both(FILL, H);
+}
+
+static void test_copy_split_matches_single_core(void) {
+  for (int32_t rows = 2; rows <= BUF_ROWS; rows++) render_both(COPY, rows);
+  render_both(COPY, H);
+}
+
+static void test_blend_split_matches_single_core(void) {
+  for (int32_t rows = 2; rows <= BUF_ROWS; rows++) render_both(BLEND, rows);
+  render_both(BLEND, H);
+}
+
+static void test_threshold_decides_the_split(void) {
+  job_t j = {FILL, single, source, W, LV_COLOR_MAKE(0, 0, 0), LV_OPA_COVER};
+  band_split_set_threshold(W * 4);
+  TEST_ASSERT_FALSE(band_split_run(3, W * 3, band, &j));
+  TEST_ASSERT_TRUE(band_split_run(4, W * 4, band, &j));
+  TEST_ASSERT_FALSE(band_split_run(1, W * 8, band, &j));   // One row cannot be split
+
+  band_split_stats_t s;
+  band_split_get_stats(&s);
+  TEST_ASSERT_EQUAL_UINT32(1, s.split);
+  TEST_ASSERT_EQUAL_UINT32(2, s.single);
+}
+
+int main(int argc, char **argv) {
+  draw_pattern(source, 99);
+  band_split_begin();           // Without the worker nothing splits and the split tests fail
+
+  UNITY_BEGIN();
+  RUN_TEST(test_fill_split_matches_single_core);
+  RUN_TEST(test_copy_split_matches_single_core);
+  RUN_TEST(test_blend_split_matches_single_core);
+  RUN_TEST(test_threshold_decides_the_split);
+  return UNITY_END();
+}
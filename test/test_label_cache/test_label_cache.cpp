@@ -0,0 +1,181 @@
+/*
+ * Label bitmap cache (pio test -e native)
+ *
+ * A row whose text comes from the cache must look like the same row with a
+ * label, and the cache must keep to its byte budget: least recently used
+ * images go first, images on screen are never evicted, and deleting the
+ * object that shows an image lets it go.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lvgl.h>
+#include <unity.h>
+#include "label_cache.h"
+#include "menu_rows.h"
+
+static const uint32_t screenWidth = 320;
+static const uint32_t screenHeight = 240;
+static lv_color_t buf[screenWidth * 10];
+static lv_disp_draw_buf_t draw_buf;
+static lv_disp_drv_t disp_drv;
+static uint16_t panel[screenWidth * screenHeight];   // What the display shows
+static uint16_t with_label[screenWidth * screenHeight];
+
+static const lv_font_t *font = LV_FONT_DEFAULT;
+static const lv_color_t black = LV_COLOR_MAKE(0x00, 0x00, 0x00);
+static const lv_color_t blue = LV_COLOR_MAKE(0x00, 0x00, 0xFF);
+
+void setUp(void) {
+  label_cache_clear();
+  label_cache_reset_stats();
+}
+
+void tearDown(void) {
+}
+
+static void flush_to_panel(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  for (int32_t y = area->y1; y <= area->y2; y++) {
+    for (int32_t x = area->x1; x <= area->x2; x++) panel[y * screenWidth + x] = (color_p++)->full;
+  }
+  lv_disp_flush_ready(disp);
+}
+
+// Render a one-row list, the row made by add, into the panel
+static void draw_row(lv_obj_t *(*add)(lv_obj_t *, const void *, const char *)) {
+  lv_obj_t *list = lv_list_create(lv_scr_act());
+  add(list, LV_SYMBOL_RIGHT, "SubItem");
+  lv_obj_align(list, LV_ALIGN_CENTER, 0, 0);
+  lv_obj_invalidate(lv_scr_act());
+  lv_refr_now(NULL);
+  lv_obj_del(list);
+}
+
+// Largest difference of one colour channel between two RGB565 pixels
+static int32_t channel_diff(uint16_t a, uint16_t b) {
+  int32_t r = abs((a >> 11) - (b >> 11)), g = abs(((a >> 5) & 63) - ((b >> 5) & 63)), bl = abs((a & 31) - (b & 31));
+  return r > g ? (r > bl ? r : bl) : (g > bl ? g : bl);
+}
+
+static void test_cached_row_looks_like_a_label_row(void) {
+  draw_row(menu_rows_add);
+  memcpy(with_label, panel, sizeof(panel));
+  draw_row(menu_rows_add_cached);
+
+  uint32_t text_px = 0, worst = 0;
+  for (uint32_t i = 0; i < screenWidth * screenHeight; i++) {
+    int32_t d = channel_diff(with_label[i], panel[i]);
+    if ((uint32_t)d > worst) worst = d;
+    if (with_label[i] != with_label[0]) text_px++;
+  }
+  TEST_ASSERT_GREATER_THAN_UINT32(0, text_px);   // Something was drawn
+  TEST_ASSERT_LESS_OR_EQUAL_INT32(1, worst);     // Blending an image and a glyph may round apart by one step
+
+  label_cache_stats_t s;
+  label_cache_get_stats(&s);
+  TEST_ASSERT_EQUAL_UINT32(1, s.misses);
+  TEST_ASSERT_EQUAL_UINT32(0, s.bypass);
+}
+
+static void test_key_is_text_font_and_colour(void) {
+  char text[8];
+  strcpy(text, "Item");
+  const lv_img_dsc_t *a = label_cache_get(text, font, black);
+  const lv_img_dsc_t *b = label_cache_get("Item", font, black);   // Same text at another address
+  const lv_img_dsc_t *c = label_cache_get("Item", font, blue);
+  const lv_img_dsc_t *d = label_cache_get("Items", font, black);
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_EQUAL_PTR(a, b);
+  TEST_ASSERT_TRUE(c != a && d != a && c != d);
+  TEST_ASSERT_EQUAL_UINT32(lv_txt_get_width("Item", 4, font, 0, LV_TEXT_FLAG_NONE), a->header.w);
+  TEST_ASSERT_EQUAL_UINT32(lv_font_get_line_height(font), a->header.h);
+
+  label_cache_stats_t s;
+  label_cache_get_stats(&s);
+  TEST_ASSERT_EQUAL_UINT32(1, s.hits);
+  TEST_ASSERT_EQUAL_UINT32(3, s.misses);
+  label_cache_release(a);
+  label_cache_release(b);
+  label_cache_release(c);
+  label_cache_release(d);
+}
+
+static void test_budget_evicts_least_recently_used(void) {
+  char text[16];
+  label_cache_stats_t s;
+  for (int i = 0; i < 64; i++) {
+    snprintf(text, sizeof(text), "Row %d", i);
+    const lv_img_dsc_t *img = label_cache_get(text, font, black);
+    TEST_ASSERT_NOT_NULL(img);
+    label_cache_release(img);
+    if (i >= 1) label_cache_release(label_cache_get("Row 0", font, black));   // Row 0 stays recent
+    label_cache_get_stats(&s);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LABEL_CACHE_BYTES, s.bytes);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LABEL_CACHE_ENTRIES, s.entries);
+  }
+  TEST_ASSERT_GREATER_THAN_UINT32(0, s.evictions);
+
+  uint32_t misses = s.misses;
+  label_cache_release(label_cache_get("Row 0", font, black));     // Used all along: still cached
+  label_cache_release(label_cache_get("Row 1", font, black));     // Long unused: rendered again
+  label_cache_get_stats(&s);
+  TEST_ASSERT_EQUAL_UINT32(misses + 1, s.misses);
+}
+
+static void test_images_on_screen_are_not_evicted(void) {
+  const lv_img_dsc_t *pinned[LABEL_CACHE_ENTRIES];
+  char text[16];
+  uint32_t n = 0;
+  const lv_img_dsc_t *img;
+  do {
+    snprintf(text, sizeof(text), "Pinned %u", (unsigned)n);
+    img = label_cache_get(text, font, black);
+    if (img) pinned[n++] = img;
+  } while (img && n < LABEL_CACHE_ENTRIES);
+
+  label_cache_stats_t s;
+  label_cache_get_stats(&s);
+  TEST_ASSERT_EQUAL_UINT32(0, s.evictions);
+  TEST_ASSERT_NULL(label_cache_get("One more", font, black));    // Full of pinned images: the caller uses a label
+  for (uint32_t i = 0; i < n; i++) {
+    snprintf(text, sizeof(text), "Pinned %u", (unsigned)i);
+    TEST_ASSERT_EQUAL_STRING(text, (const char *)pinned[i]->data + pinned[i]->data_size);   // Not overwritten
+    label_cache_release(pinned[i]);
+  }
+  img = label_cache_get("One more", font, black);
+  TEST_ASSERT_NOT_NULL(img);
+  label_cache_release(img);
+}
+
+static void test_deleting_the_image_releases_it(void) {
+  lv_obj_t *list = lv_list_create(lv_scr_act());
+  lv_obj_t *row = menu_rows_add_cached(list, NULL, "Return");
+  TEST_ASSERT_NOT_NULL(row);
+  lv_obj_del(list);
+
+  label_cache_clear();                             // Only unpinned images go
+  label_cache_stats_t s;
+  label_cache_get_stats(&s);
+  TEST_ASSERT_EQUAL_UINT32(0, s.entries);
+  TEST_ASSERT_EQUAL_UINT32(0, s.bytes);
+}
+
+int main(int argc, char **argv) {
+  lv_init();
+  lv_disp_draw_buf_init(&draw_buf, buf, NULL, screenWidth * 10);
+  lv_disp_drv_init(&disp_drv);
+  disp_drv.hor_res = screenWidth;
+  disp_drv.ver_res = screenHeight;
+  disp_drv.flush_cb = flush_to_panel;
+  disp_drv.draw_buf = &draw_buf;
+  lv_disp_drv_register(&disp_drv);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_cached_row_looks_like_a_label_row);
+  RUN_TEST(test_key_is_text_font_and_colour);
+  RUN_TEST(test_budget_evicts_least_recently_used);
+  RUN_TEST(test_images_on_screen_are_not_evicted);
+  RUN_TEST(test_deleting_the_image_releases_it);
+  return UNITY_END();
+}
@@ -0,0 +1,128 @@
+/*
+ * Input-to-photon latency accounting (pio test -e native)
+ *
+ * Inputs become records only once the frame that renders them has been
+ * flushed, and the histogram percentiles stay within one bucket of the
+ * exact sample percentile: exact below 8 us, at most 1/8 above it beyond,
+ * and never above the worst latency seen.
+ */
+
+#include <stdlib.h>
+#include <unity.h>
+#include "latency.h"
+
+#define MAX_SAMPLES 1000
+
+static uint32_t now_us;
+
+void setUp(void) {
+  latency_frame_flushed(latency_frame_begin(), now_us);   // Complete anything a previous test left pending
+  latency_reset();
+}
+
+void tearDown(void) {
+}
+
+// One input shown by the next frame, lat microseconds after the edge
+static void record(uint32_t lat) {
+  now_us += 1000;
+  latency_input(LATENCY_SRC_ENCODER, now_us);
+  uint32_t frame = latency_frame_begin();
+  latency_frame_flushed(frame, now_us + lat);
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Percentile of sorted samples with the same rank rule as the histogram
+static uint32_t exact_percentile(const uint32_t *sorted, uint32_t n, uint32_t pct) {
+  uint32_t rank = (n * pct + 99) / 100;
+  return sorted[rank ? rank - 1 : 0];
+}
+
+static void test_small_latencies_are_exact(void) {
+  for (uint32_t lat = 0; lat < 8; lat++) record(lat);
+  TEST_ASSERT_EQUAL_UINT32(8, latency_count());
+  TEST_ASSERT_EQUAL_UINT32(3, latency_percentile(50));
+  TEST_ASSERT_EQUAL_UINT32(7, latency_percentile(100));
+  TEST_ASSERT_EQUAL_UINT32(0, latency_percentile(0));
+  TEST_ASSERT_EQUAL_UINT32(7, latency_max());
+}
+
+static void test_percentiles_stay_within_one_bucket(void) {
+  static uint32_t samples[MAX_SAMPLES];
+  uint32_t seed = 42;
+  for (uint32_t i = 0; i < MAX_SAMPLES; i++) {
+    seed = seed * 1103515245u + 12345u;
+    samples[i] = 500 + (seed >> 8) % 60000;    // Frames of 0.5 to 60 ms
+    record(samples[i]);
+  }
+  qsort(samples, MAX_SAMPLES, sizeof(samples[0]), compare_u32);
+
+  static const uint32_t pcts[] = {1, 10, 50, 90, 95, 99, 100};
+  for (uint32_t k = 0; k < sizeof(pcts) / sizeof(pcts[0]); k++) {
+    uint32_t exact = exact_percentile(samples, MAX_SAMPLES, pcts[k]);
+    uint32_t got = latency_percentile(pcts[k]);
+    TEST_ASSERT_TRUE(got >= exact);
+    TEST_ASSERT_TRUE(got <= exact + exact / 8);
+  }
+  TEST_ASSERT_EQUAL_UINT32(samples[MAX_SAMPLES - 1], latency_max());
+  TEST_ASSERT_EQUAL_UINT32(latency_max(), latency_percentile(100));   // Capped at the worst sample
+}
+
+static void test_bucket_edges(void) {
+  // Each power of two starts a new bucket and its predecessor closes the one before
+  for (uint32_t e = 3; e < 31; e++) {
+    latency_reset();
+    record((1u << e) - 1);
+    TEST_ASSERT_EQUAL_UINT32((1u << e) - 1, latency_percentile(50));
+    latency_reset();
+    record(1u << e);
+    TEST_ASSERT_EQUAL_UINT32(1u << e, latency_percentile(50));   // Upper bound of the bucket, capped at the worst
+  }
+}
+
+static void test_input_waits_for_the_frame_that_renders_it(void) {
+  uint32_t rendering = latency_frame_begin();
+  latency_input(LATENCY_SRC_BUTTON, 100);          // Arrives while a frame is already rendering
+  latency_frame_flushed(rendering, 200);
+  TEST_ASSERT_EQUAL_UINT32(0, latency_count());    // That frame does not show it
+
+  uint32_t next = latency_frame_begin();
+  latency_frame_flushed(next, 5100);
+  TEST_ASSERT_EQUAL_UINT32(1, latency_count());
+  TEST_ASSERT_EQUAL_UINT32(5000, latency_max());
+
+  latency_record_t r;
+  TEST_ASSERT_EQUAL_UINT32(1, latency_recent(&r, 1));
+  TEST_ASSERT_EQUAL_UINT32(100, r.input_us);
+  TEST_ASSERT_EQUAL_UINT32(LATENCY_SRC_BUTTON, r.src);
+}
+
+static void test_recent_records_oldest_first(void) {
+  for (uint32_t i = 1; i <= LATENCY_RECORDS + 3; i++) record(i * 10);
+  latency_record_t r[LATENCY_RECORDS];
+  uint32_t n = latency_recent(r, LATENCY_RECORDS);
+  TEST_ASSERT_EQUAL_UINT32(LATENCY_RECORDS, n);
+  TEST_ASSERT_EQUAL_UINT32(4 * 10, r[0].latency_us);
+  TEST_ASSERT_EQUAL_UINT32((LATENCY_RECORDS + 3) * 10, r[n - 1].latency_us);
+}
+
+static void test_full_queue_drops_inputs(void) {
+  for (uint32_t i = 0; i < LATENCY_PENDING_MAX + 4; i++) latency_input(LATENCY_SRC_TOUCH, 0);
+  latency_frame_flushed(latency_frame_begin(), 10);
+  TEST_ASSERT_EQUAL_UINT32(LATENCY_PENDING_MAX, latency_count());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_small_latencies_are_exact);
+  RUN_TEST(test_percentiles_stay_within_one_bucket);
+  RUN_TEST(test_bucket_edges);
+  RUN_TEST(test_input_waits_for_the_frame_that_renders_it);
+  RUN_TEST(test_recent_records_oldest_first);
+  RUN_TEST(test_full_queue_drops_inputs);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+/*
+ * LVGL heap soak (pio test -e native)
+ *
+ * Opens and closes the sub page many times, built like the firmware builds
+ * it (lean rows with cached text, one bubbling click callback, page arena), and checks that
+ * the LVGL pool and the page arena return to where they started: a leak of
+ * a single block per page shows up as a difference after the churn, and
+ * fragmentation as a smaller largest free block. The host pool is a real
+ * first-fit heap of the firmware's pool size, so both are measured.
+ *
+ * Set SOAK_CYCLES for a longer run, e.g. in CI:
+ *   PLATFORMIO_BUILD_FLAGS=-DSOAK_CYCLES=1000000 pio test -e native -f test_lvgl_soak
+ */
+
+#include <lvgl.h>
+#include <unity.h>
+#include "lvgl_pool.h"
+#include "menu_rows.h"
+
+#ifndef SOAK_CYCLES
+#define SOAK_CYCLES 500u         // Sub pages opened and closed per test
+#endif
+#define RENDER_EVERY 16u         // Cycles per rendered frame during the churn
+#define SUB_ROWS 4               // Rows of a sub page, "Return" included
+
+static const uint32_t screenWidth = 320;
+static const uint32_t screenHeight = 240;
+static lv_color_t buf[screenWidth * 10];
+static lv_disp_draw_buf_t draw_buf;
+static lv_disp_drv_t disp_drv;
+static lv_obj_t *list;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void flush_done(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  lv_disp_flush_ready(disp);
+}
+
+static void row_clicked(lv_event_t *e) {
+}
+
+// Build a list page like lv_create_sublist() of the firmware
+static lv_obj_t *open_page(bool arena, const char *first, const char *text, int rows) {
+  bool in_arena = arena && lvgl_arena_begin();
+  lv_obj_t *page = lv_list_create(lv_scr_act());
+  lv_obj_add_event_cb(page, row_clicked, LV_EVENT_CLICKED, NULL);
+  for (int i = 0; i < rows; i++) {
+    lv_obj_t *row = menu_rows_add_cached(page, NULL, i == 0 ? first : text);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_EVENT_BUBBLE);
+  }
+  lv_obj_align(page, LV_ALIGN_CENTER, 0, 0);
+  if (in_arena) lvgl_arena_end();
+  return page;
+}
+
+static void churn(bool arena, uint32_t cycles) {
+  for (uint32_t i = 0; i < cycles; i++) {
+    lv_obj_t *page = open_page(arena, "Return", "SubItem", SUB_ROWS);
+    if (i % RENDER_EVERY == 0) lv_refr_now(NULL);   // Render now and then so draw-time allocations are churned too
+    lv_obj_del(page);
+  }
+  lv_refr_now(NULL);
+}
+
+static void soak(bool arena) {
+  churn(arena, RENDER_EVERY);              // The arena and the first frame's buffers are taken, the pool settles
+  lvgl_pool_mon_t before, after;
+  lvgl_arena_stats_t arena_before, arena_after;
+  lvgl_pool_monitor(&before);
+  lvgl_arena_get_stats(&arena_before);
+
+  churn(arena, SOAK_CYCLES);
+
+  lvgl_pool_monitor(&after);
+  lvgl_arena_get_stats(&arena_after);
+  TEST_ASSERT_EQUAL_UINT32(before.used, after.used);
+  TEST_ASSERT_EQUAL_UINT32(before.blocks, after.blocks);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(before.biggest_free, after.biggest_free);   // No fragmentation creep
+  TEST_ASSERT_LESS_OR_EQUAL_UINT8(before.frag_pct, after.frag_pct);
+  TEST_ASSERT_EQUAL_UINT32(0, arena_after.live);
+  if (arena) {
+    TEST_ASSERT_EQUAL_UINT32(SOAK_CYCLES, arena_after.resets - arena_before.resets);  // Every page was freed whole
+  } else {
+    TEST_ASSERT_EQUAL_UINT32(arena_before.allocs, arena_after.allocs);
+  }
+}
+
+static void test_sub_pages_from_the_arena_do_not_leak(void) {
+  soak(true);
+}
+
+static void test_sub_pages_from_the_pool_do_not_leak(void) {
+  soak(false);
+}
+
+int main(int argc, char **argv) {
+  lv_init();
+  lv_disp_draw_buf_init(&draw_buf, buf, NULL, screenWidth * 10);
+  lv_disp_drv_init(&disp_drv);
+  disp_drv.hor_res = screenWidth;
+  disp_drv.ver_res = screenHeight;
+  disp_drv.flush_cb = flush_done;
+  disp_drv.draw_buf = &draw_buf;
+  lv_disp_drv_register(&disp_drv);
+  list = open_page(false, "Item", "Item", 5);   // The main list stays underneath, as on the device
+  lv_refr_now(NULL);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sub_pages_from_the_arena_do_not_leak);
+  RUN_TEST(test_sub_pages_from_the_pool_do_not_leak);
+  return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/*
+ * RGB565 render kernels against LVGL (pio test -e native)
+ *
+ * The kernels replace LVGL's blend loops, so their output has to match
+ * LVGL bit for bit: fills and copies write exactly the given pixels, and a
+ * blend gives what lv_color_mix() gives for every pixel, at every opacity.
+ * Rectangles are drawn at every start alignment and with odd and even
+ * widths into a buffer whose odd stride alternates the row alignment, and
+ * nothing around the rectangle may change.
+ */
+
+#include <string.h>
+#include <lvgl.h>
+#include <unity.h>
+#include "render_kernels.h"
+
+#define STRIDE 67               // Odd, so consecutive rows start at alternating 32-bit alignment
+#define ROWS 6
+#define MAX_W 41                // Widths 1..MAX_W cover the head, the unrolled body and the tail
+
+static uint16_t buf[STRIDE * ROWS + 1], expected[STRIDE * ROWS + 1], src[STRIDE * ROWS + 1];
+static uint32_t seed;
+
+void setUp(void) {
+  seed = 2024;
+}
+
+void tearDown(void) {
+}
+
+static uint16_t next_random(void) {
+  seed = seed * 1103515245u + 12345u;
+  return (uint16_t)(seed >> 16);
+}
+
+// Background like a menu row: runs of one colour broken by text-like pixels
+static void draw_background(uint16_t *b) {
+  uint16_t run = next_random();
+  for (uint32_t i = 0; i < STRIDE * ROWS + 1; i++) {
+    if (next_random() % 5 == 0) run = next_random();
+    b[i] = run;
+  }
+  memcpy(expected, b, sizeof(expected));
+}
+
+typedef struct {
+  lv_color_t color;
+  lv_opa_t opa;
+} mix_ctx_t;
+
+static uint16_t mix(uint16_t bg, void *ctx) {
+  const mix_ctx_t *m = (const mix_ctx_t *)ctx;
+  lv_color_t c;
+  c.full = bg;
+  return lv_color_mix(m->color, c, m->opa).full;
+}
+
+// Start offsets 0 and 1 are the two 32-bit alignments of a uint16_t buffer; 2 and 3 repeat them one pair in
+static uint16_t *rect(uint16_t *b, int32_t x) {
+  return b + STRIDE + x;   // One row of margin above
+}
+
+static void test_fill_is_exact(void) {
+  for (int32_t x = 0; x < 4; x++) {
+    for (int32_t w = 1; w <= MAX_W; w++) {
+      uint16_t color = next_random();
+      draw_background(buf);
+      for (int32_t y = 0; y < ROWS - 2; y++) {
+        for (int32_t i = 0; i < w; i++) rect(expected, x)[y * STRIDE + i] = color;
+      }
+      rgb565_fill(rect(buf, x), STRIDE, w, ROWS - 2, color);
+      TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(buf));
+    }
+  }
+}
+
+static void test_copy_is_exact(void) {
+  for (int32_t x = 0; x < 4; x++) {
+    for (int32_t w = 1; w <= MAX_W; w++) {
+      draw_background(src);
+      draw_background(buf);
+      for (int32_t y = 0; y < ROWS - 2; y++) {
+        memcpy(rect(expected, x) + y * STRIDE, src + y * STRIDE + (w & 3), w * sizeof(uint16_t));
+      }
+      rgb565_copy(rect(buf, x), STRIDE, src + (w & 3), STRIDE, w, ROWS - 2);   // Source misaligned too
+      TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(buf));
+    }
+  }
+}
+
+static void test_contiguous_copy_is_exact(void) {
+  draw_background(src);
+  draw_background(buf);
+  memcpy(expected + 1, src, 9 * 7 * sizeof(uint16_t));
+  rgb565_copy(buf + 1, 9, src, 9, 9, 7);
+  TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(buf));
+}
+
+static void test_blend_matches_lv_color_mix_at_every_opacity(void) {
+  static const int32_t widths[] = {1, 2, 3, 8, 17, MAX_W};
+  for (uint32_t opa = 0; opa <= 255; opa++) {
+    mix_ctx_t m = {{0}, (lv_opa_t)opa};
+    m.color.full = next_random();
+    for (int32_t x = 0; x < 2; x++) {
+      for (uint32_t k = 0; k < sizeof(widths) / sizeof(widths[0]); k++) {
+        int32_t w = widths[k];
+        draw_background(buf);
+        for (int32_t y = 0; y < ROWS - 2; y++) {
+          uint16_t *e = rect(expected, x) + y * STRIDE;
+          for (int32_t i = 0; i < w; i++) e[i] = mix(e[i], &m);
+        }
+        // Seeded like the draw hooks: black and its blend
+        rgb565_blend_color(rect(buf, x), STRIDE, w, ROWS - 2, mix, &m, 0, mix(0, &m));
+        TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(buf));
+      }
+    }
+  }
+}
+
+static void test_blend_of_a_flat_background_is_exact(void) {
+  mix_ctx_t m = {{0}, LV_OPA_50};
+  m.color.full = 0xF800;
+  for (int32_t x = 0; x < 2; x++) {
+    for (uint32_t i = 0; i < sizeof(buf) / sizeof(buf[0]); i++) buf[i] = 0xFFFF;   // Every pair hits the cache
+    memcpy(expected, buf, sizeof(buf));
+    for (int32_t y = 0; y < ROWS - 2; y++) {
+      for (int32_t i = 0; i < MAX_W; i++) rect(expected, x)[y * STRIDE + i] = mix(0xFFFF, &m);
+    }
+    rgb565_blend_color(rect(buf, x), STRIDE, MAX_W, ROWS - 2, mix, &m, 0xFFFF, mix(0xFFFF, &m));
+    TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(buf));
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fill_is_exact);
+  RUN_TEST(test_copy_is_exact);
+  RUN_TEST(test_contiguous_copy_is_exact);
+  RUN_TEST(test_blend_matches_lv_color_mix_at_every_opacity);
+  RUN_TEST(test_blend_of_a_flat_background_is_exact);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+/*
+ * Touch filter accuracy on noisy traces (pio test -e native)
+ *
+ * The traces are synthetic recordings of a resistive panel: a known finger
+ * path plus jitter from a fixed seed, with single-sample spikes where the
+ * panel glitches. Each test bounds how far the filtered point may stray
+ * from the path.
+ */
+
+#include <stdlib.h>
+#include <unity.h>
+#include "touch_filter.h"
+
+#define Z_PRESS 1000            // Pressure of a firm press
+
+static touch_filter_t f;
+static uint32_t seed;
+static int16_t out_x, out_y;
+
+void setUp(void) {
+  touch_filter_init(&f, NULL);
+  seed = 12345;
+}
+
+void tearDown(void) {
+}
+
+// Panel jitter of roughly +-amp pixels, bell shaped like the noise of a resistive panel
+static int16_t jitter(int amp) {
+  int32_t sum = 0;
+  for (int i = 0; i < 4; i++) {
+    seed = seed * 1103515245u + 12345u;
+    sum += (int32_t)((seed >> 16) % (2 * amp + 1)) - amp;
+  }
+  return (int16_t)(sum / 2);
+}
+
+static bool sample(int16_t x, int16_t y) {
+  return touch_filter_update(&f, true, x, y, Z_PRESS, &out_x, &out_y);
+}
+
+// Largest distance of the output from the path over n samples at a fixed point
+static int32_t rest(int16_t x, int16_t y, int n, int amp, int spike_every) {
+  int32_t worst = 0;
+  for (int i = 0; i < n; i++) {
+    int16_t sx = x + jitter(amp), sy = y + jitter(amp);
+    if (spike_every && i % spike_every == spike_every - 1) sx += 150;   // Glitch at the panel edge
+    if (sample(sx, sy)) {
+      int32_t err = abs(out_x - x) > abs(out_y - y) ? abs(out_x - x) : abs(out_y - y);
+      if (err > worst) worst = err;
+    }
+  }
+  return worst;
+}
+
+static void test_resting_finger_is_steady(void) {
+  rest(160, 120, 20, 6, 0);                        // Settle
+  int16_t last_x = out_x, last_y = out_y;
+  uint32_t moves = 0;
+  for (int i = 0; i < 200; i++) {
+    sample(160 + jitter(6), 120 + jitter(6));
+    if (out_x != last_x || out_y != last_y) moves++;
+    last_x = out_x;
+    last_y = out_y;
+  }
+  TEST_ASSERT_INT_WITHIN(4, 160, out_x);
+  TEST_ASSERT_INT_WITHIN(4, 120, out_y);
+  TEST_ASSERT_LESS_THAN_UINT32(20, moves);       // The dead-zone absorbs the jitter
+}
+
+static void test_spikes_do_not_move_the_point(void) {
+  TEST_ASSERT_LESS_OR_EQUAL_INT32(5, rest(160, 120, 300, 3, 10));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, f.stats.outliers);
+}
+
+static void test_fast_drag_is_followed(void) {
+  for (int i = 0; i < 10; i++) sample(100, 100);
+  for (int16_t x = 150; x <= 300; x += 50) sample(x, 100);   // 50 px per sample
+  for (int i = 0; i < 50; i++) sample(300, 100);
+  TEST_ASSERT_INT_WITHIN(TOUCH_FILTER_DEADZONE, 300, out_x);
+  TEST_ASSERT_EQUAL_INT16(100, out_y);
+  TEST_ASSERT_LESS_THAN_UINT32(10, f.stats.outliers);
+}
+
+static void test_slow_drag_tracks_with_bounded_lag(void) {
+  rest(50, 120, 10, 2, 0);
+  int32_t worst = 0;
+  for (int16_t x = 50; x <= 250; x += 2) {
+    sample(x + jitter(2), 120 + jitter(2));
+    if (abs(out_x - x) > worst) worst = abs(out_x - x);
+  }
+  TEST_ASSERT_LESS_OR_EQUAL_INT32(16, worst);    // Median and IIR lag at 2 px per sample
+  rest(250, 120, 30, 2, 0);
+  TEST_ASSERT_INT_WITHIN(4, 250, out_x);                                       // Settles on the end point
+}
+
+static void test_light_press_is_ignored(void) {
+  for (int i = 0; i < 20; i++) {
+    TEST_ASSERT_FALSE(touch_filter_update(&f, true, 80, 80, TOUCH_FILTER_Z_THRESHOLD - 1, &out_x, &out_y));
+  }
+  TEST_ASSERT_EQUAL_UINT32(20, f.stats.low_pressure);
+}
+
+static void test_release_is_debounced(void) {
+  rest(160, 120, 10, 0, 0);
+  for (int i = 1; i < TOUCH_FILTER_RELEASE_N; i++) {
+    TEST_ASSERT_TRUE(touch_filter_update(&f, false, 0, 0, 0, &out_x, &out_y));   // Short dropout
+  }
+  TEST_ASSERT_FALSE(touch_filter_update(&f, false, 0, 0, 0, &out_x, &out_y));
+  TEST_ASSERT_EQUAL_INT16(160, out_x);                                           // Last point held
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_resting_finger_is_steady);
+  RUN_TEST(test_spikes_do_not_move_the_point);
+  RUN_TEST(test_fast_drag_is_followed);
+  RUN_TEST(test_slow_drag_tracks_with_bounded_lag);
+  RUN_TEST(test_light_press_is_ignored);
+  RUN_TEST(test_release_is_debounced);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+"""
+Menu font subsetting (PlatformIO pre-build script)
+
+Scans the menu strings in the firmware sources and generates an LVGL font
+that only contains the glyphs those strings use, compressed by lv_font_conv.
+When the font is generated, MENU_FONT_SUBSET is defined for the whole build
+and lv_conf.h makes it the default font in place of the full Montserrat 14.
+
+Options (platformio.ini, [env] section):
+    custom_font_ttf     TTF/WOFF source font, relative to the project dir. No font
+                        ships with the repo; without one the full font is used
+    custom_font_size    Pixel size (default 14)
+    custom_font_bpp     Bits per pixel (default 4)
+    custom_font_extra   Extra characters to include (e.g. digits for live values)
+    custom_font_sources Files scanned for menu strings (default src/main.cpp)
+
+Standalone use prints the character set and size report:
+    python tools/font_subset.py [project_dir]
+"""
+
+import hashlib
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+FONT_NAME = "menu_font_subset"
+OUTPUT = os.path.join("src", "fonts", FONT_NAME + ".c")
+
+# String literals that end up on screen: list rows (also through add_row), labels and menu_* string tables
+STRING_CALLS = re.compile(
+    r'(?:lv_list_add_btn|lv_list_add_text|add_row|menu_rows_add)\s*\([^;]*?"((?:[^"\\]|\\.)*)"\s*\)'
+    r'|lv_label_set_text(?:_static)?\s*\([^,]+,\s*"((?:[^"\\]|\\.)*)"\s*\)'
+)
+MENU_TABLE = re.compile(r"\bmenu_\w*\s*\[[^\]]*\]\s*=\s*\{([^}]*)\}", re.S)
+LITERAL = re.compile(r'"((?:[^"\\]|\\.)*)"')
+
+
+def scan_strings(paths):
+    """Return the on-screen strings found in the given source files."""
+    strings = []
+    for path in paths:
+        if not os.path.isfile(path):
+            continue
+        with open(path, encoding="utf-8") as f:
+            text = f.read()
+        for m in STRING_CALLS.finditer(text):
+            strings.append(m.group(1) or m.group(2) or "")
+        for table in MENU_TABLE.finditer(text):
+            strings.extend(LITERAL.findall(table.group(1)))
+    return [bytes(s, "utf-8").decode("unicode_escape") for s in strings]
+
+
+def bitmap_bytes(c_file):
+    """Size of the glyph bitmap array in a generated LVGL font source."""
+    with open(c_file, encoding="utf-8") as f:
+        text = f.read()
+    m = re.search(r"glyph_bitmap\[\]\s*=\s*\{(.*?)\};", text, re.S)
+    return len(re.findall(r"0x[0-9a-fA-F]{2}", m.group(1))) if m else 0
+
+
+def font_conv_cmd():
+    """lv_font_conv command line prefix, or None when node tooling is missing."""
+    if shutil.which("lv_font_conv"):
+        return ["lv_font_conv"]
+    if shutil.which("npx"):
+        return ["npx", "--yes", "lv_font_conv"]
+    return None
+
+
+def run_font_conv(conv, ttf, size, bpp, out, symbols=None, rng=None):
+    cmd = conv + ["--font", ttf, "--size", str(size), "--bpp", str(bpp),
+                  "--format", "lvgl", "--lv-font-name", FONT_NAME, "-o", out]
+    cmd += ["--symbols", symbols] if symbols else ["--range", rng]
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def generate(project_dir, ttf, size, bpp, extra, sources):
+    """Generate the subset font if the character set changed. Returns True if the font exists."""
+    strings = scan_strings([os.path.join(project_dir, s) for s in sources])
+    chars = "".join(sorted(set("".join(strings) + extra) - set("\n\r\t")))
+    print("font_subset: %d strings, %d glyphs: %r" % (len(strings), len(chars), chars))
+
+    out = os.path.join(project_dir, OUTPUT)
+    stamp = hashlib.sha1(("%s|%s|%s|%s" % (ttf, size, bpp, chars)).encode()).hexdigest()
+    if os.path.isfile(out):
+        with open(out, encoding="utf-8") as f:
+            if ("font_subset:" + stamp) in f.read():
+                return True   # Up to date
+
+    ttf_path = os.path.join(project_dir, ttf) if ttf else ""
+    conv = font_conv_cmd()
+    if not ttf_path or not os.path.isfile(ttf_path) or conv is None:
+        # A subset from an older character set would drop the glyphs of new strings
+        if os.path.isfile(out):
+            os.remove(out)
+            print("font_subset: removed the outdated %s" % OUTPUT)
+        print("font_subset: no source font or lv_font_conv, keeping the full built-in font")
+        return False
+
+    os.makedirs(os.path.dirname(out), exist_ok=True)
+    run_font_conv(conv, ttf_path, size, bpp, out, symbols=chars)
+    with open(out, "a", encoding="utf-8") as f:
+        f.write("\n/* font_subset:%s */\n" % stamp)
+
+    # Compare against the same font with the full printable ASCII range
+    with tempfile.TemporaryDirectory() as tmp:
+        full = os.path.join(tmp, "full.c")
+        run_font_conv(conv, ttf_path, size, bpp, full, rng="0x20-0x7E")
+        sub_bytes, full_bytes = bitmap_bytes(out), bitmap_bytes(full)
+    print("font_subset: bitmaps %d bytes (full ASCII %d bytes, saved %d bytes)"
+          % (sub_bytes, full_bytes, full_bytes - sub_bytes))
+    return True
+
+
+def option(env, name, default):
+    return env.GetProjectOption(name, default) if env else default
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    project = env.subst("$PROJECT_DIR")
+    sources = option(env, "custom_font_sources", "src/main.cpp").split()
+    ok = generate(project, option(env, "custom_font_ttf", ""), int(option(env, "custom_font_size", "14")),
+                  int(option(env, "custom_font_bpp", "4")), option(env, "custom_font_extra", ""), sources)
+    if ok:
+        env.Append(CPPDEFINES=["MENU_FONT_SUBSET"])
+elif __name__ == "__main__":
+    root = sys.argv[1] if len(sys.argv) > 1 else os.getcwd()
+    found = scan_strings([os.path.join(root, "src", "main.cpp")])
+    print("menu strings: %r" % found)
+    print("glyphs: %r" % "".join(sorted(set("".join(found)))))
@@ -0,0 +1,240 @@
+"""
+Memory footprint report (PlatformIO extra script and standalone tool)
+
+Breaks the firmware's flash and static RAM down by subsystem from the linker
+map (which input section of which object ended up in which output section)
+and the symbol table (to split single symbols such as the draw buffer out of
+their object). The result is written as JSON so footprints can be compared
+commit over commit.
+
+Subsystems:
+    lvgl_core       LVGL except widgets and fonts
+    lvgl_widgets    LVGL widget classes (lv_btn.c, lv_list.c, ...)
+    fonts           LVGL built-in fonts and the generated menu font
+    tft_espi        TFT_eSPI
+    draw_buffer     The LVGL draw buffer `buf` of main.cpp
+    menu_state      Other variables of main.cpp (list pointers, styles, stats)
+    app             Code of main.cpp and the other modules in src/
+    framework       Arduino core and ESP-IDF
+    toolchain       libc, libgcc, libstdc++
+    other           Anything not matched above
+
+Regions: flash is what the image takes (code, read-only data and the initial
+values of .data), iram the code loaded to IRAM, dram the static RAM (.data
+and .bss). The heap (LVGL pool, shadow framebuffer) is not static and is
+reported at run time instead.
+
+Options (platformio.ini, [env] section):
+    custom_footprint_baseline   JSON of an earlier build to print deltas against
+
+PlatformIO target (the map file is produced by every build):
+    pio run -t footprint        writes $BUILD_DIR/footprint.json
+
+Standalone:
+    python tools/footprint.py firmware.elf firmware.map [--nm xtensa-esp32-elf-nm]
+                              [--baseline old.json] [-o footprint.json]
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+SUBSYSTEMS = ("lvgl_core", "lvgl_widgets", "fonts", "tft_espi", "draw_buffer", "menu_state",
+              "app", "framework", "toolchain", "other")
+REGIONS = ("flash", "iram", "dram")
+DRAW_BUFFER_SYMBOL = "buf"
+MAIN_OBJECT = "main.cpp.o"
+
+# Widget sources of LVGL 8 (src/widgets and src/extra/widgets)
+LVGL_WIDGETS = {
+    "lv_arc", "lv_bar", "lv_btn", "lv_btnmatrix", "lv_canvas", "lv_checkbox", "lv_dropdown", "lv_img",
+    "lv_label", "lv_line", "lv_roller", "lv_slider", "lv_switch", "lv_table", "lv_textarea",
+    "lv_animimg", "lv_calendar", "lv_calendar_header_arrow", "lv_calendar_header_dropdown", "lv_chart",
+    "lv_colorwheel", "lv_imgbtn", "lv_keyboard", "lv_led", "lv_list", "lv_menu", "lv_meter",
+    "lv_msgbox", "lv_span", "lv_spinbox", "lv_spinner", "lv_tabview", "lv_tileview", "lv_win",
+}
+TOOLCHAIN_LIBS = ("libc.a", "libm.a", "libgcc.a", "libstdc++.a", "libg.a", "libnosys.a")
+
+INPUT_LINE = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+OUTPUT_LINE = re.compile(r"^(\.\S+)(?:\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+)?\s*$")
+
+
+def region_of(section):
+    """Regions an output section counts against: (image in flash, run-time region) or None."""
+    if section.startswith(".iram0"):
+        return ("flash", "iram")
+    if section.startswith(".dram0.data"):
+        return ("flash", "dram")
+    if section.startswith((".dram0.bss", ".noinit")):
+        return (None, "dram")
+    if section.startswith(".flash") and "noload" not in section:
+        return ("flash", None)
+    if section.startswith((".rtc.text", ".rtc.data", ".rtc.force")):
+        return ("flash", None)
+    return None
+
+
+def subsystem_of(path):
+    """Subsystem of an input file such as lib/liblvgl.a(lv_btn.c.o) or src/main.cpp.o."""
+    p = path.replace("\\", "/")
+    member = re.search(r"\(([^)]+)\)$", p)
+    name = os.path.basename(member.group(1) if member else p)
+    stem = name.split(".")[0]
+    lower = p.lower()
+    if "lvgl" in lower and "lvgl_pool" not in lower:
+        if stem.startswith("lv_font"):
+            return "fonts"
+        return "lvgl_widgets" if stem in LVGL_WIDGETS else "lvgl_core"
+    if "tft_espi" in lower:
+        return "tft_espi"
+    if "/src/fonts/" in p or stem.startswith("menu_font"):
+        return "fonts"
+    if os.path.basename(p.split("(")[0]) in TOOLCHAIN_LIBS or "toolchain-" in lower:
+        return "toolchain"
+    if "framework" in lower or "esp-idf" in lower or "/sdk/" in lower:
+        return "framework"
+    if "/src/" in p or p.startswith("src/"):
+        return "app"
+    return "other"
+
+
+def parse_map(path):
+    """Input sections of the memory map as (output section, input section, address, size, file)."""
+    sections, out_sec, pending, started = [], None, None, False
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not started:
+                started = line.startswith("Linker script and memory map")
+                continue
+            m = OUTPUT_LINE.match(line)
+            if m:
+                out_sec, pending = m.group(1), None
+                continue
+            if line.startswith(" ") and line.strip() and " " not in line.strip() and line.strip()[0] == ".":
+                pending = line.strip()   # Long input section name, address and size follow on the next line
+                continue
+            m = INPUT_LINE.match(line)
+            if m and out_sec:
+                name = m.group(1) or pending
+                pending = None
+                size = int(m.group(3), 16)
+                if not name or name == "*fill*" or size == 0:
+                    continue
+                sections.append((out_sec, name, int(m.group(2), 16), size, m.group(4).strip()))
+    return sections
+
+
+def read_symbols(nm, elf):
+    """Defined symbols with a size as (name, address, size, type)."""
+    out = subprocess.run([nm, "-S", "-C", "--defined-only", elf], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4:
+            symbols.append((parts[3], int(parts[0], 16), int(parts[1], 16), parts[2]))
+    return symbols
+
+
+def footprint(elf, map_file, nm):
+    totals = {s: dict.fromkeys(REGIONS, 0) for s in SUBSYSTEMS}
+    main_ram = []   # (start, end) of main.cpp.o variables
+    for out_sec, _, addr, size, path in parse_map(map_file):
+        regions = region_of(out_sec)
+        if regions is None:
+            continue
+        sub = subsystem_of(path)
+        if os.path.basename(path) == MAIN_OBJECT and regions[1] == "dram":
+            sub = "menu_state"
+            main_ram.append((addr, addr + size))
+        for region in regions:
+            if region:
+                totals[sub][region] += size
+
+    # Move the draw buffer out of main.cpp's variables
+    symbols = read_symbols(nm, elf) if nm else []
+    for name, addr, size, _ in symbols:
+        if name == DRAW_BUFFER_SYMBOL and any(lo <= addr < hi for lo, hi in main_ram):
+            totals["menu_state"]["dram"] -= size
+            totals["draw_buffer"]["dram"] += size
+
+    ram_symbols = sorted((s for s in symbols if s[3] in "bBdD"), key=lambda s: -s[2])[:20]
+    return {
+        "elf": os.path.basename(elf),
+        "total": {r: sum(t[r] for t in totals.values()) for r in REGIONS},
+        "subsystems": totals,
+        "largest_ram_symbols": [{"name": n, "size": size} for n, _, size, _ in ram_symbols],
+    }
+
+
+def print_report(report, baseline=None):
+    print("footprint: %-13s %9s %9s %9s" % ("subsystem", "flash", "iram", "dram"))
+    rows = list(report["subsystems"].items()) + [("total", report["total"])]
+    for name, sizes in rows:
+        line = "footprint: %-13s %9d %9d %9d" % (name, sizes["flash"], sizes["iram"], sizes["dram"])
+        if baseline:
+            old = baseline["total"] if name == "total" else baseline["subsystems"].get(name, {})
+            deltas = [sizes[r] - old.get(r, 0) for r in REGIONS]
+            if any(deltas):
+                line += "   (%+d %+d %+d)" % tuple(deltas)
+        print(line)
+
+
+def load_baseline(path):
+    if path and os.path.isfile(path):
+        with open(path, encoding="utf-8") as f:
+            return json.load(f)
+    return None
+
+
+def write_report(report, path):
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("footprint: written to %s" % path)
+
+
+def pio_nm(env):
+    """nm of the toolchain that built the firmware (xtensa-esp32-elf-nm)."""
+    cc = env.subst("$CC")
+    return cc[:-3] + "nm" if cc.endswith("gcc") else "nm"
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    map_path = os.path.join(env.subst("$BUILD_DIR"), env.subst("${PROGNAME}.map"))
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+    def footprint_action(target, source, env):
+        elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+        report = footprint(elf, map_path, pio_nm(env))
+        baseline = env.GetProjectOption("custom_footprint_baseline", "")
+        print_report(report, load_baseline(os.path.join(env.subst("$PROJECT_DIR"), baseline) if baseline else None))
+        write_report(report, os.path.join(env.subst("$BUILD_DIR"), "footprint.json"))
+
+    env.AddCustomTarget(
+        name="footprint",
+        dependencies="$BUILD_DIR/${PROGNAME}.elf",
+        actions=footprint_action,
+        title="Footprint",
+        description="Flash and static RAM per subsystem as JSON")
+elif __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Flash and static RAM per subsystem")
+    parser.add_argument("elf")
+    parser.add_argument("map")
+    parser.add_argument("--nm", default="xtensa-esp32-elf-nm")
+    parser.add_argument("--baseline")
+    parser.add_argument("-o", "--output", default="footprint.json")
+    args = parser.parse_args()
+    result = footprint(args.elf, args.map, args.nm)
+    print_report(result, load_baseline(args.baseline))
+    write_report(result, args.output)
+    sys.exit(0)
@@ -0,0 +1,209 @@
+"""
+Menu icon conversion (PlatformIO pre-build script)
+
+Converts the PNG icons in assets/icons into run-length encoded RGB565 + alpha
+images that src/rle_img.cpp decodes line by line, straight into LVGL's line
+buffer. Every icon becomes a `const lv_img_dsc_t icon_<name>` in
+src/icons/menu_icons.c with cf = LV_IMG_CF_RAW_ALPHA. When the file is
+generated, MENU_ICONS is defined for the whole build.
+
+Encoded layout (little endian):
+    "RLE1"              magic
+    u16 offsets[h]      start of each row, relative to the end of the table
+    rows                packets that never cross a row:
+                          0x80 | (n - 1), pixel        run of n equal pixels
+                          n - 1, pixel * n             n literal pixels
+                        pixel = RGB565 low byte, high byte, alpha
+
+The PNG reader is built in (8-bit RGB/RGBA/grey/palette, not interlaced), so
+the build needs no image library.
+
+Options (platformio.ini, [env] section):
+    custom_icons_dir    Directory with the PNG icons (default assets/icons)
+
+Standalone use regenerates the icons and prints the size report:
+    python tools/rle_icons.py [project_dir]
+"""
+
+import hashlib
+import os
+import struct
+import sys
+import zlib
+
+OUTPUT = os.path.join("src", "icons", "menu_icons.c")
+MAGIC = b"RLE1"
+MAX_PACKET = 128
+
+
+def read_png(path):
+    """Decode a PNG file into (width, height, [(r, g, b, a), ...])."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("%s: not a PNG file" % path)
+
+    pos, idat, palette, trns = 8, b"", None, b""
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            w, h, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat += body
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}.get(ctype)
+    if depth != 8 or interlace or channels is None:
+        raise ValueError("%s: only 8-bit, non-interlaced PNGs are supported" % path)
+
+    raw, stride, rows, prev = zlib.decompress(idat), w * channels, [], bytearray(w * channels)
+    for y in range(h):
+        line = raw[y * (stride + 1):(y + 1) * (stride + 1)]
+        ftype, cur = line[0], bytearray(line[1:])
+        for i in range(stride):
+            a = cur[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if ftype == 1:
+                cur[i] = (cur[i] + a) & 0xFF
+            elif ftype == 2:
+                cur[i] = (cur[i] + b) & 0xFF
+            elif ftype == 3:
+                cur[i] = (cur[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                cur[i] = (cur[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+        rows.append(cur)
+        prev = cur
+
+    pixels = []
+    for row in rows:
+        for x in range(w):
+            v = row[x * channels:(x + 1) * channels]
+            if ctype == 6:
+                pixels.append(tuple(v))
+            elif ctype == 2:
+                pixels.append((v[0], v[1], v[2], 255))
+            elif ctype == 4:
+                pixels.append((v[0], v[0], v[0], v[1]))
+            elif ctype == 0:
+                pixels.append((v[0], v[0], v[0], 255))
+            else:
+                alpha = trns[v[0]] if v[0] < len(trns) else 255
+                pixels.append(palette[v[0]] + (alpha,))
+    return w, h, pixels
+
+
+def to_565(r, g, b, a):
+    """One encoded pixel; fully transparent pixels get colour 0 so they join runs."""
+    if a == 0:
+        return b"\x00\x00\x00"
+    c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+    return struct.pack("<HB", c, a)
+
+
+def encode_row(pixels):
+    out, i, n = bytearray(), 0, len(pixels)
+    while i < n:
+        run = 1
+        while i + run < n and run < MAX_PACKET and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            out += bytes([0x80 | (run - 1)]) + pixels[i]
+            i += run
+            continue
+        # Literal packet up to the next run of at least 2
+        start = i
+        while i < n and i - start < MAX_PACKET and not (i + 1 < n and pixels[i + 1] == pixels[i]):
+            i += 1
+        out += bytes([i - start - 1]) + b"".join(pixels[start:i])
+    return out
+
+
+def encode(w, h, pixels):
+    """RLE stream of one image (see the layout above)."""
+    px = [to_565(*p) for p in pixels]
+    rows = [encode_row(px[y * w:(y + 1) * w]) for y in range(h)]
+    offsets, pos = [], 0
+    for r in rows:
+        offsets.append(pos)
+        pos += len(r)
+    if pos > 0xFFFF:
+        raise ValueError("image too large for 16-bit row offsets")
+    return MAGIC + struct.pack("<%dH" % h, *offsets) + b"".join(rows)
+
+
+def c_name(path):
+    base = os.path.splitext(os.path.basename(path))[0]
+    return "icon_" + "".join(ch if ch.isalnum() else "_" for ch in base.lower())
+
+
+def generate(project_dir, icons_dir):
+    """Convert the icons if any PNG changed. Returns True if the icon source exists."""
+    src_dir = os.path.join(project_dir, icons_dir)
+    out = os.path.join(project_dir, OUTPUT)
+    pngs = sorted(os.path.join(src_dir, f) for f in os.listdir(src_dir)
+                  if f.lower().endswith(".png")) if os.path.isdir(src_dir) else []
+    if not pngs:
+        print("rle_icons: no PNG icons in %s" % icons_dir)
+        return os.path.isfile(out)
+
+    digest = hashlib.sha1(open(__file__, "rb").read())
+    for p in pngs:
+        digest.update(os.path.basename(p).encode())
+        digest.update(open(p, "rb").read())
+    stamp = digest.hexdigest()
+    if os.path.isfile(out):
+        with open(out, encoding="utf-8") as f:
+            if ("rle_icons:" + stamp) in f.read():
+                return True   # Up to date
+
+    lines = ["/* Generated by tools/rle_icons.py from %s, do not edit */" % icons_dir.replace("\\", "/"),
+             "", '#include "lvgl.h"', ""]
+    total_rle = total_raw = 0
+    for p in pngs:
+        w, h, pixels = read_png(p)
+        data = encode(w, h, pixels)
+        raw = w * h * 3   # LV_IMG_CF_TRUE_COLOR_ALPHA at 16-bit colour depth
+        total_rle += len(data)
+        total_raw += raw
+        name = c_name(p)
+        print("rle_icons: %-16s %dx%d %5d bytes (raw %5d bytes, %.0f%%)"
+              % (name, w, h, len(data), raw, 100.0 * len(data) / raw))
+        lines += ["static const uint8_t %s_data[] = {" % name]
+        lines += ["  " + "".join("0x%02x," % v for v in data[i:i + 16]) for i in range(0, len(data), 16)]
+        lines += ["};", "",
+                  "const lv_img_dsc_t %s = {" % name,
+                  "  .header.cf = LV_IMG_CF_RAW_ALPHA,",
+                  "  .header.always_zero = 0,",
+                  "  .header.reserved = 0,",
+                  "  .header.w = %d," % w,
+                  "  .header.h = %d," % h,
+                  "  .data_size = sizeof(%s_data)," % name,
+                  "  .data = %s_data," % name,
+                  "};", ""]
+    lines.append("/* rle_icons:%s */" % stamp)
+
+    os.makedirs(os.path.dirname(out), exist_ok=True)
+    with open(out, "w", encoding="utf-8") as f:
+        f.write("\n".join(lines) + "\n")
+    print("rle_icons: %d icons, %d bytes of flash (raw lv_img_dsc_t %d bytes, saved %d bytes)"
+          % (len(pngs), total_rle, total_raw, total_raw - total_rle))
+    return True
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    if generate(env.subst("$PROJECT_DIR"), env.GetProjectOption("custom_icons_dir", "assets/icons")):
+        env.Append(CPPDEFINES=["MENU_ICONS"])
+elif __name__ == "__main__":
+    generate(sys.argv[1] if len(sys.argv) > 1 else os.getcwd(), "assets/icons")
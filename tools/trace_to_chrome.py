@@ -0,0 +1,107 @@
+"""
+Profiler dump to Chrome trace converter
+
+Turns the output of the 'p' Serial command (see include/prof.h) into Chrome
+trace JSON, which chrome://tracing and ui.perfetto.dev open directly:
+
+    prof begin ticks_per_us=240 records=1024 total=5120
+    prof X flush 1 123456789 48000      timed block: name, core, start, duration (ticks)
+    prof C heap 1 123460000 20480       counter: name, core, time (ticks), value
+    prof end
+
+Timed blocks become complete events on one track per core, so a flush that
+holds up the encoder handler shows as overlapping bars; counters (LVGL heap,
+invalidated areas waiting for a refresh) become counter tracks. A capture
+can hold several dumps; each becomes its own process in the trace. Lines
+that are not part of a dump (other Serial output) are ignored, so a raw
+serial monitor log can be converted as is.
+
+The 't' Serial command produces the same JSON on the device.
+
+Usage:
+    python tools/trace_to_chrome.py serial.log [-o trace.json]
+"""
+
+import argparse
+import json
+import re
+import sys
+
+BEGIN = re.compile(r"prof begin ticks_per_us=(\d+)")
+RECORD = re.compile(r"prof ([XC]) (\S+) (\d+) (\d+) (\d+)\s*$")
+
+
+def parse_dumps(lines):
+    """Yield (ticks_per_us, [(kind, name, core, start, value)]) for every complete dump."""
+    current, rate = None, 1
+    for line in lines:
+        line = line.strip()
+        m = BEGIN.search(line)
+        if m:
+            current, rate = [], max(1, int(m.group(1)))
+            continue
+        if current is None:
+            continue
+        if line.endswith("prof end"):
+            yield rate, current
+            current = None
+            continue
+        m = RECORD.search(line)
+        if m:
+            current.append((m.group(1), m.group(2), int(m.group(3)), int(m.group(4)), int(m.group(5))))
+
+
+def unwrap(records):
+    """Tick stamps are 32-bit and wrap: follow them as signed steps from the first record."""
+    last, t = None, 0
+    for rec in records:
+        start = rec[3]
+        if last is not None:
+            step = (start - last) & 0xFFFFFFFF
+            t += step - (1 << 32) if step & 0x80000000 else step
+        last = start
+        yield rec, t
+
+
+def convert(dumps):
+    events = []
+    for pid, (rate, records) in enumerate(dumps):
+        unwrapped = list(unwrap(records))
+        base = min((t for _, t in unwrapped), default=0)
+        cores = sorted({rec[2] for rec, _ in unwrapped if rec[0] == "X"}) or [0]
+        events.append({"ph": "M", "name": "process_name", "pid": pid, "args": {"name": "dump %d" % pid}})
+        for core in cores:
+            events.append({"ph": "M", "name": "thread_name", "pid": pid, "tid": core,
+                           "args": {"name": "core %d" % core}})
+        for (kind, name, core, _, value), t in unwrapped:
+            ts = (t - base) / rate
+            if kind == "C":
+                events.append({"ph": "C", "name": name, "pid": pid, "ts": ts, "args": {"value": value}})
+            else:
+                events.append({"ph": "X", "name": name, "pid": pid, "tid": core, "ts": ts, "dur": value / rate})
+    return {"displayTimeUnit": "ns", "traceEvents": events}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert profiler dumps to Chrome trace JSON")
+    parser.add_argument("log", help="Serial capture containing one or more 'p' dumps ('-' for stdin)")
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+
+    if args.log == "-":
+        dumps = list(parse_dumps(sys.stdin))
+    else:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            dumps = list(parse_dumps(f))
+    if not dumps:
+        sys.exit("trace_to_chrome: no complete 'prof begin' ... 'prof end' dump in %s" % args.log)
+
+    trace = convert(dumps)
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(trace, f)
+    print("trace_to_chrome: %d dumps, %d events written to %s"
+          % (len(dumps), len(trace["traceEvents"]), args.output))
+
+
+if __name__ == "__main__":
+    main()